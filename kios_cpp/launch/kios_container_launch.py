@@ -0,0 +1,61 @@
+from launch import LaunchDescription
+from launch_ros.actions import ComposableNodeContainer
+from launch_ros.actions import Node
+from launch_ros.descriptions import ComposableNode
+
+
+def generate_launch_description():
+
+    # * kios nodes in one process. the task state goes from messenger to tree_node
+    # * as a unique_ptr with intra-process comms instead of through dds.
+    intra_process = [{'use_intra_process_comms': True}]
+
+    kios_container = ComposableNodeContainer(
+        name='kios_container',
+        namespace='',
+        package='rclcpp_components',
+        executable='component_container_mt',
+        composable_node_descriptions=[
+            ComposableNode(
+                package='kios_cpp',
+                plugin='Messenger',
+                name='messenger',
+                extra_arguments=intra_process),
+            ComposableNode(
+                package='kios_cpp',
+                plugin='Tactician',
+                name='tactician',
+                extra_arguments=intra_process),
+            ComposableNode(
+                package='kios_cpp',
+                plugin='Commander',
+                name='commander',
+                extra_arguments=intra_process),
+            ComposableNode(
+                package='kios_cpp',
+                plugin='TreeNode',
+                name='tree_node',
+                extra_arguments=intra_process),
+        ],
+        output='screen',
+    )
+
+    mongo_reader = Node(
+        package='kios_py',
+        namespace='',
+        executable='mongo_reader',
+        name='mongo_reader'
+    )
+
+    mios_reader = Node(
+        package='kios_py',
+        namespace='',
+        executable='mios_reader',
+        name='mios_reader'
+    )
+
+    return LaunchDescription([
+        mios_reader,
+        mongo_reader,
+        kios_container,
+    ])
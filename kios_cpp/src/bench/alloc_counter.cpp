@@ -0,0 +1,111 @@
+#include "alloc_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<std::uint64_t> allocation_count{0};
+    thread_local std::uint64_t thread_allocation_count = 0;
+
+    void *counted_malloc(std::size_t size)
+    {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        thread_allocation_count++;
+        if (void *ptr = std::malloc(size == 0 ? 1 : size))
+        {
+            return ptr;
+        }
+        throw std::bad_alloc();
+    }
+
+    void *counted_aligned_alloc(std::size_t size, std::align_val_t alignment)
+    {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        thread_allocation_count++;
+        const std::size_t align = static_cast<std::size_t>(alignment);
+        // * aligned_alloc wants the size as a multiple of the alignment
+        if (void *ptr = std::aligned_alloc(align, (size + align - 1) / align * align))
+        {
+            return ptr;
+        }
+        throw std::bad_alloc();
+    }
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    return counted_malloc(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return counted_malloc(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    return counted_aligned_alloc(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return counted_aligned_alloc(size, alignment);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace kios
+{
+    namespace bench
+    {
+        std::uint64_t get_allocation_count()
+        {
+            return allocation_count.load(std::memory_order_relaxed);
+        }
+
+        std::uint64_t get_thread_allocation_count()
+        {
+            return thread_allocation_count;
+        }
+    } // namespace bench
+} // namespace kios
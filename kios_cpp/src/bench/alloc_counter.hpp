@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace kios
+{
+    namespace bench
+    {
+        /**
+         * @brief number of calls to the global operator new since the start of the program.
+         * counted by the replacement operator new of alloc_counter.cpp, link it into the benchmark executable.
+         * ! operator new of all threads is counted, measure in a quiet phase.
+         */
+        std::uint64_t get_allocation_count();
+
+        /**
+         * @brief number of calls to the global operator new made by the calling thread.
+         */
+        std::uint64_t get_thread_allocation_count();
+    } // namespace bench
+} // namespace kios
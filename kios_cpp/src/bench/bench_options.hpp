@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "mios_emulator.hpp"
+
+namespace kios
+{
+    namespace bench
+    {
+        /**
+         * @brief command line options of the form key=value.
+         */
+        class BenchOptions
+        {
+        public:
+            BenchOptions(int argc, char **argv)
+            {
+                for (int i = 1; i < argc; i++)
+                {
+                    const std::string arg(argv[i]);
+                    const std::size_t pos = arg.find('=');
+                    if (pos == std::string::npos)
+                    {
+                        std::cerr << "ignored argument " << arg << " (expected key=value)" << std::endl;
+                        continue;
+                    }
+                    options_[arg.substr(0, pos)] = arg.substr(pos + 1);
+                }
+            }
+
+            bool has(const std::string &key) const { return options_.count(key) != 0; }
+
+            long get_int(const std::string &key, long default_value) const
+            {
+                auto it = options_.find(key);
+                return it == options_.end() ? default_value : std::strtol(it->second.c_str(), nullptr, 10);
+            }
+
+            double get_double(const std::string &key, double default_value) const
+            {
+                auto it = options_.find(key);
+                return it == options_.end() ? default_value : std::strtod(it->second.c_str(), nullptr);
+            }
+
+            std::string get_string(const std::string &key, const std::string &default_value) const
+            {
+                auto it = options_.find(key);
+                return it == options_.end() ? default_value : it->second;
+            }
+
+            /**
+             * @brief the emulator settings: port, latency_ms, jitter_ms, task_ms, failure_rate, drop_rate,
+             * task_failure_rate, telemetry_ms, echo_id (0/1) and seed.
+             */
+            MiosEmulatorConfig get_emulator_config() const
+            {
+                MiosEmulatorConfig config;
+                config.port = static_cast<int>(get_int("port", config.port));
+                config.response_latency = std::chrono::milliseconds(get_int("latency_ms", config.response_latency.count()));
+                config.response_jitter = std::chrono::milliseconds(get_int("jitter_ms", config.response_jitter.count()));
+                config.task_duration = std::chrono::milliseconds(get_int("task_ms", config.task_duration.count()));
+                config.failure_rate = get_double("failure_rate", config.failure_rate);
+                config.drop_rate = get_double("drop_rate", config.drop_rate);
+                config.task_failure_rate = get_double("task_failure_rate", config.task_failure_rate);
+                config.telemetry_period = std::chrono::milliseconds(get_int("telemetry_ms", config.telemetry_period.count()));
+                config.echoRequestId = get_int("echo_id", config.echoRequestId ? 1 : 0) != 0;
+                config.seed = static_cast<unsigned int>(get_int("seed", config.seed));
+                return config;
+            }
+
+        private:
+            std::map<std::string, std::string> options_;
+        };
+    } // namespace bench
+} // namespace kios
@@ -0,0 +1,631 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "rclcpp/rclcpp.hpp"
+
+#include "behavior_tree/tree_root.hpp"
+#include "kios_utils/kios_utils.hpp"
+#include "kios_utils/tick_scheduler.hpp"
+#include "kios_communication/boost_udp.hpp"
+
+#include "kios_interface/srv/command_request.hpp"
+#include "kios_interface/srv/fetch_skill_parameter_request.hpp"
+
+#include "alloc_counter.hpp"
+#include "latency_recorder.hpp"
+
+using std::placeholders::_1;
+using std::placeholders::_2;
+
+/**
+ * @brief benchmark of the tree_node hot loop against a simulated mios.
+ * BenchTreeNode ticks the stock nodes with the test_tree of tree_map.hpp the way tree_node does it:
+ * tick scheduler woken by the udp phase messages, fetch skill parameter -> command request on every action switch,
+ * no tick while a request is in flight.
+ * FakeMios serves command_request_service and fetch_skill_parameter_service, and answers every started task
+ * with RESUME and SUCCESS over udp like mios does.
+ * the tree is run `rounds` times, then the tick latency, the action switch latency and the allocations per tick
+ * are printed. exits with 1 if the tree failed or the timeout expired.
+ *
+ * ! the services have the names of the commander and the tactician, do not run it next to a running kios.
+ *
+ * usage: ros2 run kios_cpp kios_bench --ros-args -p rounds:=50 -p skill_duration_ms:=5
+ */
+
+/**
+ * @brief the mios side: commander + tactician services and the udp phase messages.
+ */
+class FakeMios : public rclcpp::Node
+{
+public:
+    FakeMios()
+        : Node("fake_mios"),
+          command_count_(0),
+          fetch_count_(0),
+          last_phase_stamp_(0),
+          stopThread_(false)
+    {
+        this->declare_parameter("phase_port", 18888);
+        // * from the start of a task to RESUME, and from RESUME to SUCCESS
+        this->declare_parameter("start_delay_ms", 1);
+        this->declare_parameter("skill_duration_ms", 5);
+        // * processing time of each service call
+        this->declare_parameter("service_latency_ms", 0);
+
+        start_delay_ = std::chrono::milliseconds(this->get_parameter("start_delay_ms").as_int());
+        skill_duration_ = std::chrono::milliseconds(this->get_parameter("skill_duration_ms").as_int());
+        service_latency_ = std::chrono::milliseconds(this->get_parameter("service_latency_ms").as_int());
+
+        // * a skill parameter of the usual size
+        skill_parameter_json_ = nlohmann::json{
+            {"skill", {{"objects", {{"Container", "tool_pick_test"}, {"Tool", "tool1"}}}, {"time_max", 30}, {"action_context", {{"action_name", "tool_pick"}, {"action_phase", 24}}}}},
+            {"control", {{"control_mode", 0}, {"cart_imp", {{"K_x", {1500, 1500, 1500, 150, 150, 150}}}}}},
+            {"user", {{"env_X", {0.01, 0.01, 0.002, 0.05, 0.05, 0.05}}}}}
+                                    .dump();
+
+        phase_sender_ = std::make_unique<kios::BTSender>("127.0.0.1", this->get_parameter("phase_port").as_int());
+        phase_sender_->start();
+        phase_thread_ = std::thread(&FakeMios::phase_loop, this);
+
+        callback_group_ = this->create_callback_group(rclcpp::CallbackGroupType::Reentrant);
+        command_service_ = this->create_service<kios_interface::srv::CommandRequest>(
+            "command_request_service",
+            std::bind(&FakeMios::command_callback, this, _1, _2),
+            rmw_qos_profile_services_default,
+            callback_group_);
+        fetch_skill_parameter_service_ = this->create_service<kios_interface::srv::FetchSkillParameterRequest>(
+            "fetch_skill_parameter_service",
+            std::bind(&FakeMios::fetch_skill_parameter_callback, this, _1, _2),
+            rmw_qos_profile_services_default,
+            callback_group_);
+    }
+
+    ~FakeMios()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stopThread_ = true;
+        }
+        cv_.notify_all();
+        if (phase_thread_.joinable())
+        {
+            phase_thread_.join();
+        }
+    }
+
+    /**
+     * @brief steady clock time of the last phase message handed to the sender.
+     */
+    std::chrono::steady_clock::time_point get_last_phase_stamp() const
+    {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(last_phase_stamp_.load()));
+    }
+
+    std::uint64_t get_command_count() const { return command_count_.load(); }
+    std::uint64_t get_fetch_count() const { return fetch_count_.load(); }
+
+private:
+    struct ScheduledPhase
+    {
+        std::chrono::steady_clock::time_point due;
+        std::string phase;
+    };
+
+    std::chrono::milliseconds start_delay_;
+    std::chrono::milliseconds skill_duration_;
+    std::chrono::milliseconds service_latency_;
+    std::string skill_parameter_json_;
+
+    std::atomic<std::uint64_t> command_count_;
+    std::atomic<std::uint64_t> fetch_count_;
+    std::atomic<std::chrono::steady_clock::rep> last_phase_stamp_;
+
+    // * phases to send, in due order (start delay and skill duration are the same for all tasks)
+    std::deque<ScheduledPhase> phases_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool stopThread_;
+    std::thread phase_thread_;
+    std::unique_ptr<kios::BTSender> phase_sender_;
+
+    rclcpp::CallbackGroup::SharedPtr callback_group_;
+    rclcpp::Service<kios_interface::srv::CommandRequest>::SharedPtr command_service_;
+    rclcpp::Service<kios_interface::srv::FetchSkillParameterRequest>::SharedPtr fetch_skill_parameter_service_;
+
+    void command_callback(
+        const std::shared_ptr<kios_interface::srv::CommandRequest::Request> request,
+        const std::shared_ptr<kios_interface::srv::CommandRequest::Response> response)
+    {
+        std::this_thread::sleep_for(service_latency_);
+        command_count_++;
+        const auto command_type = static_cast<kios::CommandType>(request->command_type);
+        if (command_type == kios::CommandType::STOP_OLD_START_NEW || command_type == kios::CommandType::START_NEW_TASK)
+        {
+            // * the new task runs: RESUME once it has started, SUCCESS once it is done
+            const auto now = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> lock(mtx_);
+            phases_.push_back({now + start_delay_, "RESUME"});
+            phases_.push_back({now + start_delay_ + skill_duration_, "SUCCESS"});
+            cv_.notify_one();
+        }
+        response->is_accepted = true;
+    }
+
+    void fetch_skill_parameter_callback(
+        const std::shared_ptr<kios_interface::srv::FetchSkillParameterRequest::Request> request,
+        const std::shared_ptr<kios_interface::srv::FetchSkillParameterRequest::Response> response)
+    {
+        (void)request;
+        std::this_thread::sleep_for(service_latency_);
+        fetch_count_++;
+        response->is_accepted = true;
+        response->skill_parameters_json = skill_parameter_json_;
+        response->context_version = 0;
+    }
+
+    void phase_loop()
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        while (!stopThread_)
+        {
+            if (phases_.empty())
+            {
+                cv_.wait(lock);
+                continue;
+            }
+            const auto due = phases_.front().due;
+            if (std::chrono::steady_clock::now() < due)
+            {
+                cv_.wait_until(lock, due);
+                continue;
+            }
+            std::string phase = std::move(phases_.front().phase);
+            phases_.pop_front();
+            last_phase_stamp_.store(std::chrono::steady_clock::now().time_since_epoch().count());
+            phase_sender_->push_message(std::move(phase));
+        }
+    }
+};
+
+/**
+ * @brief the tick loop of tree_node with the object and archive stages left out, instrumented.
+ */
+class BenchTreeNode : public rclcpp::Node
+{
+public:
+    explicit BenchTreeNode(std::shared_ptr<FakeMios> fake_mios)
+        : Node("bench_tree_node"),
+          fake_mios_(fake_mios),
+          tree_state_ptr_(std::make_shared<kios::TreeState>()),
+          task_state_ptr_(std::make_shared<kios::TaskState>()),
+          tree_phase_(kios::TreePhase::RESUME)
+    {
+        this->declare_parameter("phase_port", 18888);
+        this->declare_parameter("max_tick_period_ms", 10);
+        this->declare_parameter("rounds", 20);
+        this->declare_parameter("timeout_s", 120);
+
+        rounds_ = this->get_parameter("rounds").as_int();
+
+        client_callback_group_ = this->create_callback_group(rclcpp::CallbackGroupType::Reentrant);
+        fetch_skill_parameter_client_ = this->create_client<kios_interface::srv::FetchSkillParameterRequest>(
+            "fetch_skill_parameter_service",
+            rmw_qos_profile_services_default,
+            client_callback_group_);
+        command_client_ = this->create_client<kios_interface::srv::CommandRequest>(
+            "command_request_service",
+            rmw_qos_profile_services_default,
+            client_callback_group_);
+
+        tree_root_ = std::make_shared<Insertion::TreeRoot>(tree_state_ptr_, task_state_ptr_);
+        // * the stock nodes log at trace level on every tick, the console would dominate the measurement
+        spdlog::set_level(spdlog::level::warn);
+
+        tick_scheduler_ = std::make_unique<kios::TickScheduler>(
+            std::bind(&BenchTreeNode::tick, this),
+            std::chrono::milliseconds(this->get_parameter("max_tick_period_ms").as_int()));
+        udp_socket_ = std::make_shared<kios::BTReceiver>("127.0.0.1", this->get_parameter("phase_port").as_int());
+        udp_socket_->set_message_callback([this]() { tick_scheduler_->notify(); });
+    }
+
+    ~BenchTreeNode()
+    {
+        udp_socket_->set_message_callback(nullptr);
+        tick_scheduler_->stop();
+    }
+
+    /**
+     * @brief run the tree `rounds` times. blocks, the node must be spun by another thread.
+     *
+     * @return false if the tree failed or the timeout expired
+     */
+    bool run()
+    {
+        if (!command_client_->wait_for_service(std::chrono::seconds(2)) ||
+            !fetch_skill_parameter_client_->wait_for_service(std::chrono::seconds(2)))
+        {
+            RCLCPP_ERROR(this->get_logger(), "services of the fake mios are not available!");
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock_tree_phase(tree_phase_mtx_);
+            std::lock_guard<std::mutex> lock_tree(tree_mtx_);
+            if (!tree_root_->register_nodes() || !start_round())
+            {
+                return false;
+            }
+        }
+        std::future<bool> done = done_promise_.get_future();
+        tick_scheduler_->start();
+        const bool isFinished = done.wait_for(std::chrono::seconds(this->get_parameter("timeout_s").as_int())) == std::future_status::ready;
+        tick_scheduler_->stop();
+        if (!isFinished)
+        {
+            RCLCPP_ERROR(this->get_logger(), "timeout after %d of %d rounds!", rounds_completed_, rounds_);
+            return false;
+        }
+        return done.get();
+    }
+
+    /**
+     * @brief print the results. call after run().
+     */
+    void report()
+    {
+        std::cout << "\n"
+                  << rounds_completed_ << " rounds, " << action_switch_count_ << " action switches, "
+                  << tick_count_ << " tree ticks, " << fake_mios_->get_fetch_count() << " fetch / "
+                  << fake_mios_->get_command_count() << " command requests\n"
+                  << std::endl;
+        tick_latency_.report("tick (phase, tree tick, switch check)");
+        tick_once_latency_.report("  of which TreeRoot::tick_once");
+        phase_latency_.report("mios phase sent -> tick");
+        switch_latency_.report("action switch -> command accepted");
+        if (tick_count_ > 0)
+        {
+            std::cout << std::fixed << std::setprecision(2)
+                      << "allocations per tick: " << static_cast<double>(tick_allocations_) / tick_count_
+                      << " (tick_once: " << static_cast<double>(tick_once_allocations_) / tick_count_ << ")" << std::endl;
+        }
+    }
+
+private:
+    std::shared_ptr<FakeMios> fake_mios_;
+
+    std::mutex tree_mtx_;
+    std::mutex tree_phase_mtx_;
+
+    // * guarded by tree_phase_mtx_
+    kios::TreePhase tree_phase_;
+    bool hasPendingRequest_ = false;
+    std::chrono::steady_clock::time_point pending_request_deadline_;
+    bool isDone_ = false;
+    std::promise<bool> done_promise_;
+    int rounds_ = 0;
+    int rounds_completed_ = 0;
+
+    // * guarded by tree_mtx_
+    std::shared_ptr<kios::TreeState> tree_state_ptr_;
+    std::shared_ptr<kios::TaskState> task_state_ptr_;
+    std::shared_ptr<Insertion::TreeRoot> tree_root_;
+    bool isActionSuccess_ = false;
+    std::string skill_parameter_json_ = "null";
+
+    // * measurement, tick thread and response handlers (both under tree_phase_mtx_)
+    kios::bench::LatencyRecorder tick_latency_;
+    kios::bench::LatencyRecorder tick_once_latency_;
+    kios::bench::LatencyRecorder phase_latency_;
+    kios::bench::LatencyRecorder switch_latency_;
+    std::uint64_t tick_count_ = 0;
+    std::uint64_t tick_allocations_ = 0;
+    std::uint64_t tick_once_allocations_ = 0;
+    std::uint64_t action_switch_count_ = 0;
+    std::chrono::steady_clock::time_point switch_start_;
+
+    std::unique_ptr<kios::TickScheduler> tick_scheduler_;
+    std::shared_ptr<kios::BTReceiver> udp_socket_;
+
+    rclcpp::CallbackGroup::SharedPtr client_callback_group_;
+    rclcpp::Client<kios_interface::srv::FetchSkillParameterRequest>::SharedPtr fetch_skill_parameter_client_;
+    rclcpp::Client<kios_interface::srv::CommandRequest>::SharedPtr command_client_;
+
+    /**
+     * @brief end the benchmark.
+     * ! call with tree_phase_mtx_ held.
+     */
+    void finish(bool isSucceeded)
+    {
+        if (!isDone_)
+        {
+            isDone_ = true;
+            done_promise_.set_value(isSucceeded);
+        }
+    }
+
+    /**
+     * @brief a fresh tree and state, as in a newly started tree_node.
+     * ! call with tree_phase_mtx_ and tree_mtx_ held.
+     */
+    bool start_round()
+    {
+        *tree_state_ptr_ = kios::TreeState();
+        task_state_ptr_->isActionSuccess = false;
+        isActionSuccess_ = false;
+        if (!tree_root_->construct_tree(Insertion::test_tree) || !tree_root_->archive_nodes().has_value())
+        {
+            RCLCPP_ERROR(this->get_logger(), "failed to build the test tree!");
+            return false;
+        }
+        tree_phase_ = kios::TreePhase::RESUME;
+        return true;
+    }
+
+    /**
+     * @brief the same as TreeNode::timer_callback.
+     */
+    void tick()
+    {
+        const auto tick_start = std::chrono::steady_clock::now();
+        const std::uint64_t allocations_before = kios::bench::get_thread_allocation_count();
+
+        std::lock_guard<std::mutex> lock_tree_phase(tree_phase_mtx_);
+        if (isDone_)
+        {
+            return;
+        }
+        if (hasPendingRequest_)
+        {
+            if (tick_start > pending_request_deadline_)
+            {
+                RCLCPP_ERROR(this->get_logger(), "response is not ready after the deadline!");
+                finish(false);
+            }
+            return;
+        }
+
+        std::string message;
+        if (udp_socket_->get_message(message))
+        {
+            // * one phase message in flight at a time, the last stamp is the one of this message
+            phase_latency_.add(tick_start - fake_mios_->get_last_phase_stamp());
+            if (!kios::switch_tree_phase(message, tree_phase_))
+            {
+                RCLCPP_ERROR(this->get_logger(), "undefined tree phase %s!", message.c_str());
+                finish(false);
+                return;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock_tree(tree_mtx_);
+        tree_state_ptr_->tree_phase = tree_phase_;
+        if (tree_cycle())
+        {
+            tick_latency_.add(std::chrono::steady_clock::now() - tick_start);
+            tick_allocations_ += kios::bench::get_thread_allocation_count() - allocations_before;
+            tick_count_++;
+        }
+    }
+
+    /**
+     * @brief the same as TreeNode::tree_cycle.
+     *
+     * @return true if the tree was ticked
+     */
+    bool tree_cycle()
+    {
+        switch (tree_phase_)
+        {
+        case kios::TreePhase::PAUSE: {
+            isActionSuccess_ = false;
+            return false;
+        }
+        case kios::TreePhase::RESUME: {
+            return execute_tree();
+        }
+        case kios::TreePhase::SUCCESS: {
+            isActionSuccess_ = true;
+            return execute_tree();
+        }
+        case kios::TreePhase::FINISH: {
+            // * stop the tasks on mios side, then the next round
+            skill_parameter_json_ = "null";
+            if (!send_command_request(kios::CommandType::STOP_OLD_TASK, [this]() { return complete_round(); }))
+            {
+                finish(false);
+            }
+            return false;
+        }
+        default: {
+            RCLCPP_ERROR(this->get_logger(), "tree_cycle: tree phase %d!", static_cast<int>(tree_phase_));
+            finish(false);
+            return false;
+        }
+        }
+    }
+
+    /**
+     * @brief the same as TreeNode::execute_tree.
+     */
+    bool execute_tree()
+    {
+        task_state_ptr_->isActionSuccess = isActionSuccess_;
+
+        const std::uint64_t allocations_before = kios::bench::get_thread_allocation_count();
+        const auto tick_once_start = std::chrono::steady_clock::now();
+        const BT::NodeStatus tick_result = tree_root_->tick_once();
+        tick_once_latency_.add(std::chrono::steady_clock::now() - tick_once_start);
+        tick_once_allocations_ += kios::bench::get_thread_allocation_count() - allocations_before;
+
+        if (tree_state_ptr_->tree_phase == kios::TreePhase::ERROR || tick_result == BT::NodeStatus::FAILURE)
+        {
+            RCLCPP_ERROR(this->get_logger(), "execute_tree: the tree failed!");
+            finish(false);
+            return true;
+        }
+        if (tick_result == BT::NodeStatus::SUCCESS)
+        {
+            kios::switch_tree_phase("FINISH", tree_phase_);
+            return true;
+        }
+        if (check_action_switch())
+        {
+            kios::switch_tree_phase("PAUSE", tree_phase_);
+            tree_state_ptr_->tree_phase = tree_phase_;
+            action_switch_count_++;
+            switch_start_ = std::chrono::steady_clock::now();
+            if (!send_fetch_skill_parameter_request())
+            {
+                finish(false);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief the same as TreeNode::check_action_switch.
+     */
+    bool check_action_switch()
+    {
+        if (tree_state_ptr_->isSucceeded)
+        {
+            tree_state_ptr_->isSucceeded = false;
+        }
+        else if (tree_state_ptr_->action_phase == tree_state_ptr_->last_action_phase)
+        {
+            return false;
+        }
+        tree_state_ptr_->last_action_name = tree_state_ptr_->action_name;
+        tree_state_ptr_->last_action_phase = tree_state_ptr_->action_phase;
+        tree_state_ptr_->last_node_archive = tree_state_ptr_->node_archive;
+        return true;
+    }
+
+    /**
+     * @brief the commander accepted STOP_OLD_TASK.
+     * ! call with tree_phase_mtx_ and tree_mtx_ held.
+     */
+    bool complete_round()
+    {
+        rounds_completed_++;
+        if (rounds_completed_ >= rounds_)
+        {
+            finish(true);
+            return true;
+        }
+        return start_round();
+    }
+
+    /**
+     * @brief the same as TreeNode::send_request_async, the deadline is fixed to 1 s.
+     * ! call with tree_phase_mtx_ held.
+     */
+    template <typename ServiceT>
+    bool send_request_async(
+        const typename rclcpp::Client<ServiceT>::SharedPtr &client,
+        const std::shared_ptr<typename ServiceT::Request> &request,
+        std::function<bool(std::shared_ptr<typename ServiceT::Response>)> handler)
+    {
+        if (!client->service_is_ready())
+        {
+            return false;
+        }
+        hasPendingRequest_ = true;
+        pending_request_deadline_ = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        client->async_send_request(
+            request,
+            [this, handler = std::move(handler)](typename rclcpp::Client<ServiceT>::SharedFuture future)
+            {
+                {
+                    std::lock_guard<std::mutex> lock_tree_phase(tree_phase_mtx_);
+                    if (!hasPendingRequest_ || isDone_)
+                    {
+                        return;
+                    }
+                    hasPendingRequest_ = false;
+                    std::lock_guard<std::mutex> lock_tree(tree_mtx_);
+                    if (!handler(future.get()))
+                    {
+                        finish(false);
+                    }
+                }
+                tick_scheduler_->notify();
+            });
+        return true;
+    }
+
+    bool send_fetch_skill_parameter_request()
+    {
+        auto request = std::make_shared<kios_interface::srv::FetchSkillParameterRequest::Request>();
+        request->node_archive = tree_state_ptr_->node_archive.to_ros2_msg();
+        request->tree_phase = static_cast<int32_t>(tree_state_ptr_->tree_phase);
+        request->object_keys = tree_state_ptr_->object_keys;
+        request->object_names = tree_state_ptr_->object_names;
+        request->accept_binary = false;
+        return send_request_async<kios_interface::srv::FetchSkillParameterRequest>(
+            fetch_skill_parameter_client_,
+            request,
+            [this](std::shared_ptr<kios_interface::srv::FetchSkillParameterRequest::Response> result)
+            {
+                if (!result->is_accepted)
+                {
+                    return false;
+                }
+                skill_parameter_json_ = std::move(result->skill_parameters_json);
+                return send_command_request(
+                    kios::CommandType::STOP_OLD_START_NEW,
+                    [this]()
+                    {
+                        switch_latency_.add(std::chrono::steady_clock::now() - switch_start_);
+                        return true;
+                    });
+            });
+    }
+
+    bool send_command_request(kios::CommandType cmd_type, std::function<bool()> on_accepted)
+    {
+        auto request = std::make_shared<kios_interface::srv::CommandRequest::Request>();
+        request->command_type = static_cast<int32_t>(cmd_type);
+        request->command_context = skill_parameter_json_;
+        request->skill_type = kios::ap_to_mios_skill(tree_state_ptr_->node_archive.action_phase);
+        return send_request_async<kios_interface::srv::CommandRequest>(
+            command_client_,
+            request,
+            [on_accepted = std::move(on_accepted)](std::shared_ptr<kios_interface::srv::CommandRequest::Response> result)
+            {
+                return result->is_accepted && on_accepted();
+            });
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    rclcpp::init(argc, argv);
+    auto fake_mios = std::make_shared<FakeMios>();
+    auto bench_tree_node = std::make_shared<BenchTreeNode>(fake_mios);
+
+    rclcpp::executors::MultiThreadedExecutor executor;
+    executor.add_node(fake_mios);
+    executor.add_node(bench_tree_node);
+    std::thread spin_thread([&executor]() { executor.spin(); });
+
+    const bool isSucceeded = bench_tree_node->run();
+
+    executor.cancel();
+    spin_thread.join();
+    bench_tree_node->report();
+
+    bench_tree_node.reset();
+    fake_mios.reset();
+    rclcpp::shutdown();
+    return isSucceeded ? 0 : 1;
+}
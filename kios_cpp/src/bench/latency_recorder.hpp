@@ -0,0 +1,78 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace kios
+{
+    namespace bench
+    {
+        /**
+         * @brief collects latency samples and prints their percentiles.
+         * the capacity is reserved up front, add() does not allocate: samples beyond the capacity are counted and dropped.
+         * ! not thread safe.
+         */
+        class LatencyRecorder
+        {
+        public:
+            explicit LatencyRecorder(std::size_t capacity = 100000)
+                : dropped_count_(0)
+            {
+                samples_us_.reserve(capacity);
+            }
+
+            void add(std::chrono::steady_clock::duration latency)
+            {
+                if (samples_us_.size() == samples_us_.capacity())
+                {
+                    dropped_count_++;
+                    return;
+                }
+                samples_us_.push_back(std::chrono::duration<double, std::micro>(latency).count());
+            }
+
+            std::size_t size() const { return samples_us_.size(); }
+
+            /**
+             * @brief print count, p50, p90, p99 and max in microseconds.
+             */
+            void report(const std::string &name, std::ostream &os = std::cout) const
+            {
+                os << std::left << std::setw(44) << name << std::right;
+                if (samples_us_.empty())
+                {
+                    os << "no samples" << std::endl;
+                    return;
+                }
+                std::vector<double> sorted = samples_us_;
+                std::sort(sorted.begin(), sorted.end());
+                // * nearest rank
+                auto percentile = [&sorted](double p)
+                {
+                    const std::size_t rank = static_cast<std::size_t>(std::ceil(p / 100.0 * sorted.size()));
+                    return sorted[std::max<std::size_t>(rank, 1) - 1];
+                };
+                os << std::fixed << std::setprecision(1)
+                   << "n=" << std::setw(7) << sorted.size()
+                   << "  p50=" << std::setw(9) << percentile(50)
+                   << "  p90=" << std::setw(9) << percentile(90)
+                   << "  p99=" << std::setw(9) << percentile(99)
+                   << "  max=" << std::setw(9) << sorted.back() << " us";
+                if (dropped_count_ > 0)
+                {
+                    os << "  (" << dropped_count_ << " dropped)";
+                }
+                os << std::endl;
+            }
+
+        private:
+            std::vector<double> samples_us_;
+            std::size_t dropped_count_;
+        };
+    } // namespace bench
+} // namespace kios
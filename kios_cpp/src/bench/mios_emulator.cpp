@@ -0,0 +1,452 @@
+#include "mios_emulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <spdlog/spdlog.h>
+
+namespace kios
+{
+    namespace
+    {
+        // * finished tasks kept for late wait_for_task calls
+        constexpr std::size_t kMaxFinishedTasks = 1024;
+    } // namespace
+
+    MiosEmulator::MiosEmulator(const MiosEmulatorConfig &config)
+        : config_(config),
+          isRunning_(false),
+          next_task_uuid_(1),
+          telemetry_sample_(0),
+          random_engine_(config.seed),
+          calls_received_(0),
+          responses_sent_(0),
+          calls_dropped_(0),
+          failures_injected_(0),
+          tasks_started_(0),
+          tasks_finished_(0),
+          telemetry_sent_(0)
+    {
+        m_server.clear_access_channels(websocketpp::log::alevel::all);
+        m_server.clear_error_channels(websocketpp::log::elevel::all);
+        m_server.set_error_channels(websocketpp::log::elevel::rerror | websocketpp::log::elevel::fatal);
+
+        m_server.set_open_handler(websocketpp::lib::bind(&MiosEmulator::on_open, this, websocketpp::lib::placeholders::_1));
+        m_server.set_close_handler(websocketpp::lib::bind(&MiosEmulator::on_close, this, websocketpp::lib::placeholders::_1));
+        m_server.set_message_handler(websocketpp::lib::bind(
+            &MiosEmulator::on_message,
+            this,
+            websocketpp::lib::placeholders::_1,
+            websocketpp::lib::placeholders::_2));
+    }
+
+    MiosEmulator::~MiosEmulator()
+    {
+        stop();
+    }
+
+    /**
+     * @brief listen on the port and run the server thread.
+     *
+     * @return false if the port cannot be opened
+     */
+    bool MiosEmulator::start()
+    {
+        if (isRunning_.load())
+        {
+            return true;
+        }
+        websocketpp::lib::error_code ec;
+        m_server.init_asio(ec);
+        if (ec)
+        {
+            spdlog::error("mios emulator: init failed: {}", ec.message());
+            return false;
+        }
+        m_server.set_reuse_addr(true);
+        m_server.listen(static_cast<std::uint16_t>(config_.port), ec);
+        if (ec)
+        {
+            spdlog::error("mios emulator: cannot listen on port {}: {}", config_.port, ec.message());
+            return false;
+        }
+        m_server.start_accept(ec);
+        if (ec)
+        {
+            spdlog::error("mios emulator: accept failed: {}", ec.message());
+            return false;
+        }
+        telemetry_sender_ = std::make_unique<BTSender>("127.0.0.1", 0);
+        telemetry_sender_->start();
+
+        isRunning_.store(true);
+        schedule_telemetry();
+        serverThread = std::thread([this]()
+                                   { m_server.run(); });
+        spdlog::info("mios emulator: listening on {}", get_uri());
+        return true;
+    }
+
+    /**
+     * @brief close the connections and stop the server thread.
+     */
+    void MiosEmulator::stop()
+    {
+        if (!isRunning_.exchange(false))
+        {
+            return;
+        }
+        m_server.get_io_service().post([this]()
+                                       {
+            websocketpp::lib::error_code ec;
+            m_server.stop_listening(ec);
+            for (const auto &hdl : connections_)
+            {
+                m_server.close(hdl, websocketpp::close::status::going_away, "mios emulator stopped", ec);
+            }
+            // * give the closing handshakes a moment, then stop the loop with the pending timers
+            m_server.set_timer(200, [this](const websocketpp::lib::error_code &)
+                               { m_server.stop(); }); });
+        if (serverThread.joinable())
+        {
+            serverThread.join();
+        }
+        telemetry_sender_.reset();
+    }
+
+    std::string MiosEmulator::get_uri() const
+    {
+        return "ws://localhost:" + std::to_string(config_.port) + "/mios/core";
+    }
+
+    MiosEmulatorStatistics MiosEmulator::get_statistics() const
+    {
+        MiosEmulatorStatistics statistics;
+        statistics.calls_received = calls_received_.load();
+        statistics.responses_sent = responses_sent_.load();
+        statistics.calls_dropped = calls_dropped_.load();
+        statistics.failures_injected = failures_injected_.load();
+        statistics.tasks_started = tasks_started_.load();
+        statistics.tasks_finished = tasks_finished_.load();
+        statistics.telemetry_sent = telemetry_sent_.load();
+        return statistics;
+    }
+
+    void MiosEmulator::on_open(websocketpp::connection_hdl hdl)
+    {
+        connections_.insert(hdl);
+    }
+
+    void MiosEmulator::on_close(websocketpp::connection_hdl hdl)
+    {
+        connections_.erase(hdl);
+    }
+
+    /**
+     * @brief handle a call {"method": ..., "request": ..., "request_id": ...}.
+     */
+    void MiosEmulator::on_message(websocketpp::connection_hdl hdl, mios_server::message_ptr msg)
+    {
+        calls_received_++;
+        nlohmann::json call;
+        try
+        {
+            call = nlohmann::json::parse(msg->get_payload());
+        }
+        catch (nlohmann::json::parse_error &e)
+        {
+            spdlog::warn("mios emulator: call is not json: {}", e.what());
+            return;
+        }
+        if (!call.is_object() || !call.contains("method") || !call["method"].is_string())
+        {
+            spdlog::warn("mios emulator: call without method: {}", msg->get_payload());
+            return;
+        }
+        Caller caller{hdl, call.contains("request_id") ? call["request_id"] : nlohmann::json()};
+        const std::string method = call["method"].get<std::string>();
+        const nlohmann::json request = call.contains("request") ? call["request"] : nlohmann::json();
+
+        // * failure injection
+        if (draw(config_.drop_rate))
+        {
+            calls_dropped_++;
+            return;
+        }
+        if (draw(config_.failure_rate))
+        {
+            failures_injected_++;
+            respond(caller, make_result(false, "injected failure"));
+            return;
+        }
+
+        if (method == "start_task")
+        {
+            const int task_uuid = start_task(draw(config_.task_failure_rate));
+            nlohmann::json result = make_result(true);
+            result["result"]["task_uuid"] = task_uuid;
+            respond(caller, std::move(result));
+        }
+        else if (method == "start_and_monitor")
+        {
+            // * answered when the task is finished
+            const int task_uuid = start_task(draw(config_.task_failure_rate));
+            tasks_[task_uuid].waiters.push_back(caller);
+        }
+        else if (method == "wait_for_task")
+        {
+            handle_wait_for_task(caller, request);
+        }
+        else if (method == "stop_task")
+        {
+            handle_stop_task(caller);
+        }
+        else if (method == "subscribe_telemetry")
+        {
+            handle_subscribe_telemetry(caller, request);
+        }
+        else if (method == "unsubscribe_telemetry")
+        {
+            handle_unsubscribe_telemetry(caller, request);
+        }
+        else if (method == "teach_object" || method == "set_grasped_object")
+        {
+            if (!request.is_object() || !request.contains("object"))
+            {
+                respond(caller, make_result(false, "no object given"));
+                return;
+            }
+            respond(caller, make_result(true));
+        }
+        else
+        {
+            respond(caller, make_result(false, "unknown method " + method));
+        }
+    }
+
+    bool MiosEmulator::draw(double probability)
+    {
+        if (probability <= 0.0)
+        {
+            return false;
+        }
+        return std::uniform_real_distribution<double>(0.0, 1.0)(random_engine_) < probability;
+    }
+
+    nlohmann::json MiosEmulator::make_result(bool result, const std::string &error)
+    {
+        return {{"result", {{"result", result}, {"error", error}}}};
+    }
+
+    nlohmann::json MiosEmulator::make_task_result(int task_uuid, const Task &task)
+    {
+        nlohmann::json result = make_result(task.result, task.error);
+        result["result"]["task_uuid"] = task_uuid;
+        // * the python commander reads error_msg
+        result["result"]["error_msg"] = task.error;
+        return result;
+    }
+
+    /**
+     * @brief send the response after the configured latency.
+     */
+    void MiosEmulator::respond(const Caller &caller, nlohmann::json result)
+    {
+        if (config_.echoRequestId && !caller.request_id.is_null())
+        {
+            result["request_id"] = caller.request_id;
+        }
+        auto send = [this, hdl = caller.hdl, payload = result.dump()]()
+        {
+            websocketpp::lib::error_code ec;
+            m_server.send(hdl, payload, websocketpp::frame::opcode::text, ec);
+            if (ec)
+            {
+                spdlog::warn("mios emulator: send failed: {}", ec.message());
+                return;
+            }
+            responses_sent_++;
+        };
+
+        std::chrono::milliseconds latency = config_.response_latency;
+        if (config_.response_jitter.count() > 0)
+        {
+            latency += std::chrono::milliseconds(
+                std::uniform_int_distribution<std::chrono::milliseconds::rep>(0, config_.response_jitter.count())(random_engine_));
+        }
+        if (latency.count() == 0)
+        {
+            send();
+            return;
+        }
+        m_server.set_timer(latency.count(), [send = std::move(send)](const websocketpp::lib::error_code &ec)
+                           {
+            if (!ec)
+            {
+                send();
+            } });
+    }
+
+    /**
+     * @brief start a task that finishes after task_duration.
+     *
+     * @return int the task uuid
+     */
+    int MiosEmulator::start_task(bool hasTaskFailure)
+    {
+        const int task_uuid = next_task_uuid_++;
+        tasks_[task_uuid];
+        tasks_started_++;
+        // * forget the oldest finished tasks
+        while (tasks_.size() > kMaxFinishedTasks && tasks_.begin()->second.isFinished)
+        {
+            tasks_.erase(tasks_.begin());
+        }
+        m_server.set_timer(config_.task_duration.count(), [this, task_uuid, hasTaskFailure](const websocketpp::lib::error_code &ec)
+                           {
+            if (!ec)
+            {
+                finish_task(task_uuid, !hasTaskFailure, hasTaskFailure ? "injected task failure" : "");
+            } });
+        return task_uuid;
+    }
+
+    /**
+     * @brief set the task result and answer its waiters. a finished (or stopped) task is not finished again.
+     */
+    void MiosEmulator::finish_task(int task_uuid, bool result, const std::string &error)
+    {
+        auto task_it = tasks_.find(task_uuid);
+        if (task_it == tasks_.end() || task_it->second.isFinished)
+        {
+            return;
+        }
+        Task &task = task_it->second;
+        task.isFinished = true;
+        task.result = result;
+        task.error = error;
+        tasks_finished_++;
+        const nlohmann::json task_result = make_task_result(task_uuid, task);
+        for (const auto &waiter : task.waiters)
+        {
+            respond(waiter, task_result);
+        }
+        task.waiters.clear();
+    }
+
+    /**
+     * @brief the request is the task uuid, or {"task_uuid": ...} as sent by the python client.
+     */
+    void MiosEmulator::handle_wait_for_task(const Caller &caller, const nlohmann::json &request)
+    {
+        const nlohmann::json &uuid = request.is_object() && request.contains("task_uuid") ? request["task_uuid"] : request;
+        if (!uuid.is_number_integer())
+        {
+            respond(caller, make_result(false, "no task uuid given"));
+            return;
+        }
+        const int task_uuid = uuid.get<int>();
+        auto task_it = tasks_.find(task_uuid);
+        if (task_it == tasks_.end())
+        {
+            respond(caller, make_result(false, "unknown task " + std::to_string(task_uuid)));
+            return;
+        }
+        if (task_it->second.isFinished)
+        {
+            respond(caller, make_task_result(task_uuid, task_it->second));
+            return;
+        }
+        task_it->second.waiters.push_back(caller);
+    }
+
+    /**
+     * @brief stop all running tasks. their waiters get result false.
+     */
+    void MiosEmulator::handle_stop_task(const Caller &caller)
+    {
+        for (auto &task : tasks_)
+        {
+            finish_task(task.first, false, "task stopped");
+        }
+        respond(caller, make_result(true));
+    }
+
+    void MiosEmulator::handle_subscribe_telemetry(const Caller &caller, const nlohmann::json &request)
+    {
+        try
+        {
+            TelemetrySubscription subscription;
+            const std::string ip = request.at("ip").get<std::string>();
+            subscription.endpoint = boost::asio::ip::udp::endpoint(
+                boost::asio::ip::address::from_string(ip),
+                request.at("port").get<unsigned short>());
+            subscription.fields = request.at("subscribe").get<std::vector<std::string>>();
+            telemetry_subscriptions_[ip] = std::move(subscription);
+        }
+        catch (const std::exception &e)
+        {
+            respond(caller, make_result(false, std::string("invalid subscription: ") + e.what()));
+            return;
+        }
+        respond(caller, make_result(true));
+    }
+
+    void MiosEmulator::handle_unsubscribe_telemetry(const Caller &caller, const nlohmann::json &request)
+    {
+        if (request.is_object() && request.contains("ip") && request["ip"].is_string())
+        {
+            telemetry_subscriptions_.erase(request["ip"].get<std::string>());
+        }
+        respond(caller, make_result(true));
+    }
+
+    /**
+     * @brief send one telemetry datagram to every subscriber each telemetry_period.
+     */
+    void MiosEmulator::schedule_telemetry()
+    {
+        m_server.set_timer(std::max<std::chrono::milliseconds::rep>(config_.telemetry_period.count(), 1), [this](const websocketpp::lib::error_code &ec)
+                           {
+            if (ec || !isRunning_.load())
+            {
+                return;
+            }
+            telemetry_sample_++;
+            for (const auto &subscription : telemetry_subscriptions_)
+            {
+                telemetry_sender_->push_message(make_telemetry(subscription.second.fields), subscription.second.endpoint);
+                telemetry_sent_++;
+            }
+            schedule_telemetry(); });
+    }
+
+    /**
+     * @brief the subscribed fields of a flat mios telemetry datagram. the wrench oscillates slowly.
+     */
+    std::string MiosEmulator::make_telemetry(const std::vector<std::string> &fields)
+    {
+        const double t = static_cast<double>(telemetry_sample_) * static_cast<double>(config_.telemetry_period.count()) / 1000.0;
+        nlohmann::json telemetry = nlohmann::json::object();
+        for (const auto &field : fields)
+        {
+            if (field == "TF_F_ext_K")
+            {
+                telemetry[field] = {0.1 * std::sin(t), 0.1 * std::cos(t), 5.0 + 3.0 * std::sin(0.5 * t), 0.0, 0.0, 0.0};
+            }
+            else if (field == "T_T_EE" || field == "O_T_EE")
+            {
+                telemetry[field] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.3, 0.0, 0.5, 1};
+            }
+            else if (field == "tau_ext" || field == "q")
+            {
+                telemetry[field] = std::vector<double>(7, 0.0);
+            }
+            else if (field == "system_time")
+            {
+                telemetry[field] = t;
+            }
+        }
+        return telemetry.dump();
+    }
+} // namespace kios
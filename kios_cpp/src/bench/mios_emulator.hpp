@@ -0,0 +1,147 @@
+#pragma once
+
+#include "websocketpp/config/asio_no_tls.hpp"
+#include "websocketpp/server.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kios_communication/boost_udp.hpp"
+
+namespace kios
+{
+    typedef websocketpp::server<websocketpp::config::asio> mios_server;
+
+    /**
+     * @brief behavior of the emulated mios. the probabilities are per call (per task for task_failure_rate).
+     */
+    struct MiosEmulatorConfig
+    {
+        int port = 12000;
+        // * delay of every response, plus a uniform random part in [0, response_jitter]
+        std::chrono::milliseconds response_latency{0};
+        std::chrono::milliseconds response_jitter{0};
+        // * time from the start of a task to its result
+        std::chrono::milliseconds task_duration{10};
+        // * the call is answered with result false
+        double failure_rate = 0.0;
+        // * the call is not answered at all
+        double drop_rate = 0.0;
+        // * the task ends with result false
+        double task_failure_rate = 0.0;
+        // * period of the telemetry datagrams to the subscribers of subscribe_telemetry
+        std::chrono::milliseconds telemetry_period{1};
+        // * the real mios does not send the request id back, set false to test the fallback of the client
+        bool echoRequestId = true;
+        unsigned int seed = 0;
+    };
+
+    struct MiosEmulatorStatistics
+    {
+        std::uint64_t calls_received = 0;
+        std::uint64_t responses_sent = 0;
+        std::uint64_t calls_dropped = 0;
+        std::uint64_t failures_injected = 0;
+        std::uint64_t tasks_started = 0;
+        std::uint64_t tasks_finished = 0;
+        std::uint64_t telemetry_sent = 0;
+    };
+
+    /**
+     * @brief local stand-in of the mios websocket server (ws://localhost:<port>/mios/core) for offline load tests
+     * of BTMessenger. implements start_task, stop_task, start_and_monitor, wait_for_task, subscribe_telemetry,
+     * unsubscribe_telemetry, teach_object and set_grasped_object with the response format of mios.
+     * the request id of a call is sent back with its response (see MiosEmulatorConfig::echoRequestId).
+     * all the calls are handled in the server thread, the responses are delayed with timers of the server.
+     */
+    class MiosEmulator
+    {
+    public:
+        explicit MiosEmulator(const MiosEmulatorConfig &config = MiosEmulatorConfig());
+        ~MiosEmulator();
+
+        MiosEmulator(const MiosEmulator &) = delete;
+        MiosEmulator &operator=(const MiosEmulator &) = delete;
+
+        bool start();
+        void stop();
+        bool is_running() const { return isRunning_.load(); }
+
+        std::string get_uri() const;
+        MiosEmulatorStatistics get_statistics() const;
+
+    private:
+        // * where a response goes
+        struct Caller
+        {
+            websocketpp::connection_hdl hdl;
+            nlohmann::json request_id; // null if the call had none
+        };
+
+        struct Task
+        {
+            bool isFinished = false;
+            bool result = false;
+            std::string error;
+            // * start_and_monitor and wait_for_task calls answered at the end of the task
+            std::vector<Caller> waiters;
+        };
+
+        struct TelemetrySubscription
+        {
+            boost::asio::ip::udp::endpoint endpoint;
+            std::vector<std::string> fields;
+        };
+
+        MiosEmulatorConfig config_;
+        mios_server m_server;
+        std::thread serverThread;
+        std::atomic_bool isRunning_;
+
+        // * server thread only
+        std::set<websocketpp::connection_hdl, std::owner_less<websocketpp::connection_hdl>> connections_;
+        std::map<int, Task> tasks_;
+        int next_task_uuid_;
+        std::map<std::string, TelemetrySubscription> telemetry_subscriptions_; // key: ip
+        std::uint64_t telemetry_sample_;
+        std::mt19937 random_engine_;
+        std::unique_ptr<BTSender> telemetry_sender_;
+
+        std::atomic<std::uint64_t> calls_received_;
+        std::atomic<std::uint64_t> responses_sent_;
+        std::atomic<std::uint64_t> calls_dropped_;
+        std::atomic<std::uint64_t> failures_injected_;
+        std::atomic<std::uint64_t> tasks_started_;
+        std::atomic<std::uint64_t> tasks_finished_;
+        std::atomic<std::uint64_t> telemetry_sent_;
+
+        void on_open(websocketpp::connection_hdl hdl);
+        void on_close(websocketpp::connection_hdl hdl);
+        void on_message(websocketpp::connection_hdl hdl, mios_server::message_ptr msg);
+
+        bool draw(double probability);
+        void respond(const Caller &caller, nlohmann::json result);
+        static nlohmann::json make_result(bool result, const std::string &error = "");
+        nlohmann::json make_task_result(int task_uuid, const Task &task);
+
+        int start_task(bool hasTaskFailure);
+        void finish_task(int task_uuid, bool result, const std::string &error);
+        void handle_wait_for_task(const Caller &caller, const nlohmann::json &request);
+        void handle_stop_task(const Caller &caller);
+        void handle_subscribe_telemetry(const Caller &caller, const nlohmann::json &request);
+        void handle_unsubscribe_telemetry(const Caller &caller, const nlohmann::json &request);
+
+        void schedule_telemetry();
+        std::string make_telemetry(const std::vector<std::string> &fields);
+    };
+} // namespace kios
@@ -0,0 +1,53 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <thread>
+
+#include "mios_emulator.hpp"
+
+#include "bench_options.hpp"
+
+/**
+ * @brief run the mios emulator until ctrl-c, e.g. in place of mios for the tree_node.
+ *
+ * usage: mios_emulator [port=12000] [latency_ms=0] [jitter_ms=0] [task_ms=10] [failure_rate=0]
+ *                      [drop_rate=0] [task_failure_rate=0] [telemetry_ms=1] [echo_id=1] [seed=0]
+ */
+
+namespace
+{
+    std::atomic_bool isInterrupted{false};
+
+    void signal_handler(int)
+    {
+        isInterrupted.store(true);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const kios::bench::BenchOptions options(argc, argv);
+    kios::MiosEmulator emulator(options.get_emulator_config());
+    if (!emulator.start())
+    {
+        return 1;
+    }
+    std::signal(SIGINT, signal_handler);
+    std::signal(SIGTERM, signal_handler);
+
+    while (!isInterrupted.load())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    emulator.stop();
+
+    const kios::MiosEmulatorStatistics statistics = emulator.get_statistics();
+    std::cout << "calls: " << statistics.calls_received
+              << ", responses: " << statistics.responses_sent
+              << ", dropped: " << statistics.calls_dropped
+              << ", injected failures: " << statistics.failures_injected
+              << ", tasks: " << statistics.tasks_started << "/" << statistics.tasks_finished
+              << ", telemetry: " << statistics.telemetry_sent << std::endl;
+    return 0;
+}
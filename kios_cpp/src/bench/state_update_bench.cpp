@@ -0,0 +1,136 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "kios_utils/data_type.hpp"
+#include "kios_utils/triple_buffer.hpp"
+
+#include "alloc_counter.hpp"
+
+/**
+ * @brief time and heap allocations of updating the in-process state from the messenger messages,
+ * the path of every task state subscription hit in tree_node.
+ * exits with 1 if any update allocates.
+ *
+ * usage: state_update_bench [iterations]
+ */
+
+namespace
+{
+    /**
+     * @brief run update(i) for i in [0, iterations) and report the time and allocations per update.
+     *
+     * @return true if no update allocated
+     */
+    template <typename Update>
+    bool run_case(const std::string &name, std::size_t iterations, Update &&update)
+    {
+        // * warm up, the first update may touch memory lazily set up
+        update(0);
+
+        const std::uint64_t allocations_before = kios::bench::get_allocation_count();
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < iterations; i++)
+        {
+            update(i);
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        const std::uint64_t allocations = kios::bench::get_allocation_count() - allocations_before;
+
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        std::cout << std::left << std::setw(40) << name << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(10) << ns / iterations << " ns/update"
+                  << std::setprecision(3) << std::setw(10) << static_cast<double>(allocations) / iterations << " allocations/update"
+                  << (allocations == 0 ? "" : "  <-- ALLOCATES") << std::endl;
+        return allocations == 0;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const std::size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    if (iterations == 0)
+    {
+        std::cerr << "usage: state_update_bench [iterations]" << std::endl;
+        return 2;
+    }
+
+    // * messages as received by the subscriptions, filled once outside the measurement
+    kios_interface::msg::TaskState task_state_msg;
+    task_state_msg.mios_state.tf_f_ext_k.assign(6, 0.0);
+    task_state_msg.mios_state.t_t_ee.assign(16, 0.0);
+    task_state_msg.sensor_state.test_data.assign(6, 0.0);
+    kios_interface::msg::TaskStateFixed task_state_fixed_msg;
+
+    kios::TaskState task_state;
+    kios::PerceptionState perception;
+    kios::TripleBuffer<kios::PerceptionState> perception_buffer;
+
+    bool isAllocationFree = true;
+
+    isAllocationFree &= run_case("MiosState <- MiosState", iterations,
+                                 [&](std::size_t i)
+                                 {
+                                     task_state_msg.mios_state.tf_f_ext_k[2] = static_cast<double>(i);
+                                     task_state.mios_state.from_ros2_msg(task_state_msg.mios_state);
+                                 });
+
+    isAllocationFree &= run_case("SensorState <- SensorState", iterations,
+                                 [&](std::size_t i)
+                                 {
+                                     task_state_msg.sensor_state.test_data[0] = static_cast<double>(i);
+                                     task_state.sensor_state.from_ros2_msg(task_state_msg.sensor_state);
+                                 });
+
+    isAllocationFree &= run_case("PerceptionState <- TaskState", iterations,
+                                 [&](std::size_t i)
+                                 {
+                                     task_state_msg.mios_state.tf_f_ext_k[2] = static_cast<double>(i);
+                                     perception.from_ros2_msg(task_state_msg);
+                                 });
+
+    isAllocationFree &= run_case("PerceptionState <- TaskStateFixed", iterations,
+                                 [&](std::size_t i)
+                                 {
+                                     task_state_fixed_msg.mios_state.tf_f_ext_k[2] = static_cast<double>(i);
+                                     perception.from_ros2_msg(task_state_fixed_msg);
+                                 });
+
+    // * subscription callback and tick in one thread: write, publish, take over into the task state
+    isAllocationFree &= run_case("subscription -> tick (TripleBuffer)", iterations,
+                                 [&](std::size_t i)
+                                 {
+                                     task_state_msg.mios_state.tf_f_ext_k[2] = static_cast<double>(i);
+                                     perception_buffer.write_buffer().from_ros2_msg(task_state_msg);
+                                     perception_buffer.publish();
+                                     if (perception_buffer.update())
+                                     {
+                                         const auto &latest = perception_buffer.read();
+                                         task_state.mios_state = latest.mios_state;
+                                         task_state.sensor_state = latest.sensor_state;
+                                         task_state.telemetry = latest.telemetry;
+                                     }
+                                 });
+
+    // * a snapshot taken by value, e.g. ThreadSafeData<PerceptionState>::read_data()
+    double snapshot_sum = 0;
+    isAllocationFree &= run_case("PerceptionState copy", iterations,
+                                 [&](std::size_t i)
+                                 {
+                                     perception.mios_state.tf_f_ext_k[2] = static_cast<double>(i);
+                                     const kios::PerceptionState snapshot = perception;
+                                     snapshot_sum += snapshot.mios_state.tf_f_ext_k[2];
+                                 });
+
+    // * keep the results observable
+    std::cout << "last f_z: " << task_state.mios_state.tf_f_ext_k[2] << ", " << snapshot_sum << std::endl;
+
+    if (!isAllocationFree)
+    {
+        std::cerr << "state update allocates!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
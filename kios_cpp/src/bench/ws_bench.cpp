@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "kios_communication/ws_client.hpp"
+
+#include "bench_options.hpp"
+#include "latency_recorder.hpp"
+#include "mios_emulator.hpp"
+
+/**
+ * @brief throughput and latency of BTMessenger against the mios emulator (or a running mios with uri=...).
+ * phases:
+ *  - call: sequential short calls (call_async + wait_for_call), one in flight
+ *  - pipeline: short calls with up to inflight calls in flight, completed by callbacks
+ *  - start_and_monitor: task round trips through start_and_monitor_async
+ *  - start_task + wait_for_task: task round trips in two calls
+ * exits with 1 if a call failed or timed out, except for the ones the emulator was told to fail.
+ *
+ * usage: ws_bench [calls=10000] [inflight=32] [tasks=200] [timeout_ms=2000] [method=teach_object]
+ *                 [uri=ws://...] plus the emulator options of mios_emulator
+ */
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct PhaseResult
+    {
+        std::size_t succeeded = 0;
+        std::size_t failed = 0;   // result false
+        std::size_t timed_out = 0; // no response (dropped, cancelled, disconnected)
+
+        void count(const std::optional<nlohmann::json> &response)
+        {
+            if (!response.has_value())
+            {
+                timed_out++;
+            }
+            else if (response->contains("result") && response->at("result").is_object() && response->at("result").value("result", false))
+            {
+                succeeded++;
+            }
+            else
+            {
+                failed++;
+            }
+        }
+
+        void report(Clock::duration elapsed) const
+        {
+            const double seconds = std::chrono::duration<double>(elapsed).count();
+            const std::size_t total = succeeded + failed + timed_out;
+            std::cout << "    " << total << " calls in " << seconds << " s (" << total / seconds << " calls/s), "
+                      << failed << " failed, " << timed_out << " timed out" << std::endl;
+        }
+    };
+
+    /**
+     * @brief short calls one by one.
+     */
+    PhaseResult run_sequential(BTMessenger &messenger, const std::string &method, const nlohmann::json &payload,
+                               std::size_t calls, int timeout)
+    {
+        kios::bench::LatencyRecorder latency(calls);
+        PhaseResult result;
+        const auto start = Clock::now();
+        for (std::size_t i = 0; i < calls; i++)
+        {
+            const auto sent = Clock::now();
+            PendingCallHandle handle = messenger.call_async(method, payload);
+            const std::optional<nlohmann::json> response = messenger.wait_for_call(handle, timeout);
+            latency.add(Clock::now() - sent);
+            result.count(response);
+        }
+        const auto elapsed = Clock::now() - start;
+        latency.report("call (" + method + ")");
+        result.report(elapsed);
+        return result;
+    }
+
+    /**
+     * @brief short calls with up to inflight calls in flight. a new call is sent as soon as one completes.
+     */
+    PhaseResult run_pipelined(BTMessenger &messenger, const std::string &method, const nlohmann::json &payload,
+                              std::size_t calls, std::size_t inflight, int timeout)
+    {
+        struct Shared
+        {
+            std::mutex mtx;
+            std::condition_variable cv;
+            std::size_t inflight = 0;
+            kios::bench::LatencyRecorder latency;
+            PhaseResult result;
+
+            explicit Shared(std::size_t capacity) : latency(capacity) {}
+        };
+        auto shared = std::make_shared<Shared>(calls);
+        std::vector<std::uint64_t> request_ids;
+        request_ids.reserve(calls);
+
+        const auto start = Clock::now();
+        for (std::size_t i = 0; i < calls; i++)
+        {
+            {
+                std::unique_lock<std::mutex> lock(shared->mtx);
+                // * a dropped call never frees its slot
+                if (!shared->cv.wait_for(lock, std::chrono::milliseconds(timeout), [&]()
+                                         { return shared->inflight < inflight; }))
+                {
+                    shared->result.timed_out += calls - i;
+                    break;
+                }
+                shared->inflight++;
+            }
+            const auto sent = Clock::now();
+            request_ids.push_back(messenger.call_async(method, payload, false,
+                                                       [shared, sent](std::optional<nlohmann::json> response)
+                                                       {
+                                                           const auto received = Clock::now();
+                                                           std::lock_guard<std::mutex> lock(shared->mtx);
+                                                           shared->latency.add(received - sent);
+                                                           shared->result.count(response);
+                                                           shared->inflight--;
+                                                           shared->cv.notify_all();
+                                                       }));
+        }
+        {
+            std::unique_lock<std::mutex> lock(shared->mtx);
+            shared->cv.wait_for(lock, std::chrono::milliseconds(timeout), [&]()
+                                { return shared->inflight == 0; });
+        }
+        const auto elapsed = Clock::now() - start;
+        // * the calls still pending complete with std::nullopt and count as timed out
+        for (const std::uint64_t request_id : request_ids)
+        {
+            messenger.cancel_call(request_id);
+        }
+
+        std::lock_guard<std::mutex> lock(shared->mtx);
+        shared->latency.report("pipeline (" + method + ", " + std::to_string(inflight) + " in flight)");
+        shared->result.report(elapsed);
+        return shared->result;
+    }
+
+    /**
+     * @brief tasks one by one through start_and_monitor_async.
+     */
+    PhaseResult run_start_and_monitor(BTMessenger &messenger, std::size_t tasks, int timeout)
+    {
+        kios::bench::LatencyRecorder latency(tasks);
+        PhaseResult result;
+        const nlohmann::json skill_context = {{"skill", {{"objects", nlohmann::json::object()}}}};
+        const auto start = Clock::now();
+        for (std::size_t i = 0; i < tasks; i++)
+        {
+            auto promise = std::make_shared<std::promise<std::optional<nlohmann::json>>>();
+            std::future<std::optional<nlohmann::json>> future = promise->get_future();
+            const auto sent = Clock::now();
+            const std::uint64_t request_id = messenger.start_and_monitor_async(
+                skill_context, "BBGeneric",
+                [promise](std::optional<nlohmann::json> response)
+                { promise->set_value(std::move(response)); });
+            if (future.wait_for(std::chrono::milliseconds(timeout)) != std::future_status::ready)
+            {
+                messenger.cancel_call(request_id);
+            }
+            const std::optional<nlohmann::json> response = future.get();
+            latency.add(Clock::now() - sent);
+            result.count(response);
+        }
+        const auto elapsed = Clock::now() - start;
+        latency.report("start_and_monitor");
+        result.report(elapsed);
+        return result;
+    }
+
+    std::optional<int> get_task_uuid(const std::optional<nlohmann::json> &response)
+    {
+        if (!response.has_value() || !response->contains("result") || !response->at("result").is_object())
+        {
+            return std::nullopt;
+        }
+        const nlohmann::json &result = response->at("result");
+        if (!result.value("result", false) || !result.contains("task_uuid") || !result.at("task_uuid").is_number_integer())
+        {
+            return std::nullopt;
+        }
+        return result.at("task_uuid").get<int>();
+    }
+
+    /**
+     * @brief tasks one by one through start_task + wait_for_task.
+     */
+    PhaseResult run_start_and_wait(BTMessenger &messenger, std::size_t tasks, int timeout)
+    {
+        kios::bench::LatencyRecorder latency(tasks);
+        PhaseResult result;
+        const nlohmann::json skill_context = {{"skill", {{"objects", nlohmann::json::object()}}}};
+        const auto start = Clock::now();
+        for (std::size_t i = 0; i < tasks; i++)
+        {
+            const auto sent = Clock::now();
+            PendingCallHandle start_handle = messenger.start_task_async(skill_context, "BBGeneric");
+            const std::optional<nlohmann::json> started = messenger.wait_for_call(start_handle, timeout);
+            const std::optional<int> task_uuid = get_task_uuid(started);
+            if (!task_uuid.has_value())
+            {
+                result.count(started);
+                continue;
+            }
+            PendingCallHandle wait_handle = messenger.wait_for_task_result_async(task_uuid.value());
+            const std::optional<nlohmann::json> response = messenger.wait_for_call(wait_handle, timeout);
+            latency.add(Clock::now() - sent);
+            result.count(response);
+        }
+        const auto elapsed = Clock::now() - start;
+        latency.report("start_task + wait_for_task");
+        result.report(elapsed);
+        return result;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const kios::bench::BenchOptions options(argc, argv);
+    const std::size_t calls = static_cast<std::size_t>(options.get_int("calls", 10000));
+    const std::size_t inflight = static_cast<std::size_t>(std::max(1L, options.get_int("inflight", 32)));
+    const std::size_t tasks = static_cast<std::size_t>(options.get_int("tasks", 200));
+    const int timeout = static_cast<int>(options.get_int("timeout_ms", 2000));
+    const std::string method = options.get_string("method", "teach_object");
+    const nlohmann::json payload = {{"object", "ring"}};
+
+    // * in-process emulator unless a uri is given
+    const kios::MiosEmulatorConfig config = options.get_emulator_config();
+    std::unique_ptr<kios::MiosEmulator> emulator;
+    std::string uri = options.get_string("uri", "");
+    if (uri.empty())
+    {
+        emulator = std::make_unique<kios::MiosEmulator>(config);
+        if (!emulator->start())
+        {
+            return 1;
+        }
+        uri = emulator->get_uri();
+    }
+
+    BTMessenger messenger(uri);
+    // * the messenger logs every message at trace level
+    spdlog::set_level(spdlog::level::warn);
+    if (!messenger.special_connect() || !messenger.wait_for_open_connection(5))
+    {
+        std::cerr << "cannot connect to " << uri << std::endl;
+        return 1;
+    }
+
+    std::cout << "ws_bench against " << uri << std::endl;
+    PhaseResult total;
+    auto accumulate = [&total](const PhaseResult &result)
+    {
+        total.succeeded += result.succeeded;
+        total.failed += result.failed;
+        total.timed_out += result.timed_out;
+    };
+    accumulate(run_sequential(messenger, method, payload, calls, timeout));
+    accumulate(run_pipelined(messenger, method, payload, calls, inflight, timeout));
+    accumulate(run_start_and_monitor(messenger, tasks, timeout));
+    accumulate(run_start_and_wait(messenger, tasks, timeout));
+
+    messenger.close();
+    if (emulator)
+    {
+        emulator->stop();
+        const kios::MiosEmulatorStatistics statistics = emulator->get_statistics();
+        std::cout << "emulator: " << statistics.calls_received << " calls, "
+                  << statistics.responses_sent << " responses, "
+                  << statistics.calls_dropped << " dropped, "
+                  << statistics.failures_injected << " injected failures" << std::endl;
+    }
+
+    // * failures are expected only if the emulator injects them
+    const bool hasInjection = config.failure_rate > 0 || config.drop_rate > 0 || config.task_failure_rate > 0;
+    if (!hasInjection && (total.failed > 0 || total.timed_out > 0))
+    {
+        std::cerr << "ws_bench: " << total.failed << " failed and " << total.timed_out << " timed out calls!" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -6,6 +6,7 @@
 #include <any>
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 #include "spdlog/spdlog.h"
 
@@ -109,6 +110,11 @@ namespace Insertion
             return hasSucceededOnce;
         }
 
+        void reset_success()
+        {
+            hasSucceededOnce = false;
+        }
+
         // ! MAY OVERRIDE
         /////////////////////////////////////////////////////////////////
         virtual void on_success()
@@ -218,6 +224,23 @@ namespace Insertion
          *
          */
         void initialize_archive()
+        {
+            std::vector<std::string> warnings;
+            initialize_archive(warnings);
+            for (const auto &warning : warnings)
+            {
+                spdlog::warn(warning);
+            }
+            test_objects();
+        }
+
+        /**
+         * @brief initialize_archive() without logging, for the worker threads: the warnings are collected
+         * for the caller to log in tree order.
+         *
+         * @param warnings output
+         */
+        void initialize_archive(std::vector<std::string> &warnings)
         {
             auto &archive = get_archive_ref();
             // * read archive from input port
@@ -252,7 +275,7 @@ namespace Insertion
             if (!description)
             {
                 // throw BT::RuntimeError("missing required input [description]: ", description.error());
-                spdlog::warn("Action node " + std::to_string(ag) + "-" + std::to_string(action_id.value()) + " has no description.");
+                warnings.push_back("Action node " + std::to_string(ag) + "-" + std::to_string(action_id.value()) + " has no description.");
                 // here pass. use the default value of the struct.
             }
             else
@@ -261,15 +284,13 @@ namespace Insertion
             }
             if (!objects)
             {
-                spdlog::warn("Action node " + std::to_string(ag) + "-" + std::to_string(action_id.value()) + " grounds no objects.");
+                warnings.push_back("Action node " + std::to_string(ag) + "-" + std::to_string(action_id.value()) + " grounds no objects.");
             }
             else
             {
                 auto &objs = get_object_names_ref();
                 objs = objects.value();
             }
-
-            test_objects();
         }
 
     private:
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <behaviortree_cpp/bt_factory.h>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+#include "behavior_tree/meta_node/meta_node.hpp"
+
+// for demo
+#include "behavior_tree/action_node/approach.hpp"
+#include "behavior_tree/action_node/contact.hpp"
+#include "behavior_tree/action_node/wiggle.hpp"
+
+// general action nodes
+#include "behavior_tree/action_node/cartesian_move.h"
+#include "behavior_tree/action_node/joint_move.hpp"
+#include "behavior_tree/action_node/gripper_force.hpp"
+#include "behavior_tree/action_node/gripper_move.hpp"
+
+// additional
+#include "behavior_tree/action_node/tool_load.hpp"
+#include "behavior_tree/action_node/tool_unload.hpp"
+#include "behavior_tree/action_node/tool_grasp.hpp"
+#include "behavior_tree/action_node/tool_release.hpp"
+#include "behavior_tree/action_node/gripper_grasp.hpp"
+#include "behavior_tree/action_node/gripper_release.hpp"
+
+// compound in mios level
+#include "behavior_tree/compound_action_node/tool_pick.hpp"
+#include "behavior_tree/compound_action_node/tool_place.hpp"
+#include "behavior_tree/compound_action_node/gripper_pick.hpp"
+#include "behavior_tree/compound_action_node/gripper_place.hpp"
+
+// ! BBMOD
+
+#include "behavior_tree/condition_node/condition_node.hpp"
+
+#include "kios_utils/kios_utils.hpp"
+
+namespace Insertion
+{
+    namespace node_id
+    {
+        // * the ids of the nodes in the tree xml
+        inline constexpr char kHasObjectApproach[] = "HasObjectApproch";
+        inline constexpr char kHasObjectContact[] = "HasObjectContact";
+        inline constexpr char kAtPositionApproach[] = "AtPositionApproch";
+        inline constexpr char kAtPositionContact[] = "AtPositionContact";
+
+        inline constexpr char kApproach[] = "Approach";
+        inline constexpr char kContact[] = "Contact";
+        inline constexpr char kWiggle[] = "Wiggle";
+
+        inline constexpr char kCartesianMove[] = "CartesianMove";
+        inline constexpr char kJointMove[] = "JointMove";
+        inline constexpr char kGripperForce[] = "GripperForce";
+        inline constexpr char kGripperMove[] = "GripperMove";
+
+        inline constexpr char kToolLoad[] = "ToolLoad";
+        inline constexpr char kToolUnload[] = "ToolUnload";
+        inline constexpr char kToolGrasp[] = "ToolGrasp";
+        inline constexpr char kToolRelease[] = "ToolRelease";
+        inline constexpr char kGripperGrasp[] = "GripperGrasp";
+        inline constexpr char kGripperRelease[] = "GripperRelease";
+
+        inline constexpr char kToolPick[] = "ToolPick";
+        inline constexpr char kToolPlace[] = "ToolPlace";
+        inline constexpr char kGripperPick[] = "GripperPick";
+        inline constexpr char kGripperPlace[] = "GripperPlace";
+
+        // * constructor arguments of the condition nodes
+        inline constexpr char kApproachObject[] = "approach";
+        inline constexpr char kContactObject[] = "contact";
+    } // namespace node_id
+
+    namespace detail
+    {
+        template <const char *>
+        using ArgString = std::string;
+
+        constexpr bool is_same_id(const char *lhs, const char *rhs)
+        {
+            while (*lhs != '\0' && *lhs == *rhs)
+            {
+                lhs++;
+                rhs++;
+            }
+            return *lhs == *rhs;
+        }
+    } // namespace detail
+
+    /**
+     * @brief a node type of the registry: the class, its id in the tree xml and the string arguments
+     * passed to its constructor before the state pointers.
+     */
+    template <typename NodeType, const char *ID, const char *...Args>
+    struct NodeEntry
+    {
+        using Type = NodeType;
+        static constexpr const char *id = ID;
+
+        // * the checks of BehaviorTreeFactory::registerNodeType, plus the constructor of the kios nodes
+        static_assert(std::is_base_of_v<BT::ActionNodeBase, NodeType> || std::is_base_of_v<BT::ConditionNode, NodeType> ||
+                          std::is_base_of_v<BT::DecoratorNode, NodeType> || std::is_base_of_v<BT::ControlNode, NodeType>,
+                      "[NodeEntry]: the node must derive from ActionNodeBase, ConditionNode, DecoratorNode or ControlNode");
+        static_assert(!std::is_abstract_v<NodeType>, "[NodeEntry]: the node can't be abstract");
+        static_assert(std::is_constructible_v<NodeType, const std::string &, const BT::NodeConfig &,
+                                              detail::ArgString<Args>...,
+                                              std::shared_ptr<kios::TreeState>, std::shared_ptr<kios::TaskState>>,
+                      "[NodeEntry]: the node needs the constructor (name, config, args..., tree_state_ptr, task_state_ptr)");
+        static_assert(BT::has_static_method_providedPorts<NodeType>::value,
+                      "[NodeEntry]: the node must implement static PortsList providedPorts()");
+
+        static std::unique_ptr<BT::TreeNode> create(const std::string &name, const BT::NodeConfig &config,
+                                                    const std::shared_ptr<kios::TreeState> &tree_state_ptr,
+                                                    const std::shared_ptr<kios::TaskState> &task_state_ptr)
+        {
+            return std::make_unique<NodeType>(name, config, std::string(Args)..., tree_state_ptr, task_state_ptr);
+        }
+    };
+
+    /**
+     * @brief typelist of the node types known to the tree. the registration and the manifests are generated from it,
+     * and every entry gets a dense type id, its position in the list.
+     * a duplicated id or a wrong constructor is a compile error instead of an exception at startup.
+     */
+    template <typename... Entries>
+    struct NodeRegistry
+    {
+        static constexpr std::size_t size = sizeof...(Entries);
+        static constexpr std::array<const char *, size> ids = {Entries::id...};
+
+        static constexpr bool has_unique_ids()
+        {
+            for (std::size_t i = 0; i < size; i++)
+            {
+                for (std::size_t j = i + 1; j < size; j++)
+                {
+                    if (detail::is_same_id(ids[i], ids[j]))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief the type id of the node id, at compile time. an unknown id is a compile error if used in a constant expression.
+         */
+        static constexpr std::size_t type_id(const char *id)
+        {
+            for (std::size_t i = 0; i < size; i++)
+            {
+                if (detail::is_same_id(ids[i], id))
+                {
+                    return i;
+                }
+            }
+            throw std::out_of_range("unknown node id");
+        }
+
+        /**
+         * @brief the type id of a node of the tree, from its registration name.
+         *
+         * @param registration_name
+         * @return std::optional<std::size_t> std::nullopt for the nodes of BT.CPP
+         */
+        static std::optional<std::size_t> get_type_id(std::string_view registration_name)
+        {
+            for (std::size_t i = 0; i < size; i++)
+            {
+                if (registration_name == ids[i])
+                {
+                    return i;
+                }
+            }
+            return std::nullopt;
+        }
+
+        /**
+         * @brief register all the entries to the factory. the node types share the state pointers.
+         * @throw BT::BehaviorTreeException if an id is already registered in the factory
+         */
+        static void register_all(BT::BehaviorTreeFactory &factory,
+                                 const std::shared_ptr<kios::TreeState> &tree_state_ptr,
+                                 const std::shared_ptr<kios::TaskState> &task_state_ptr)
+        {
+            static_assert(has_unique_ids(), "[NodeRegistry]: two entries have the same id");
+            (register_entry<Entries>(factory, tree_state_ptr, task_state_ptr), ...);
+        }
+
+    private:
+        template <typename Entry>
+        static void register_entry(BT::BehaviorTreeFactory &factory,
+                                   const std::shared_ptr<kios::TreeState> &tree_state_ptr,
+                                   const std::shared_ptr<kios::TaskState> &task_state_ptr)
+        {
+            factory.registerBuilder(BT::CreateManifest<typename Entry::Type>(Entry::id),
+                                    [tree_state_ptr, task_state_ptr](const std::string &name, const BT::NodeConfig &config)
+                                    { return Entry::create(name, config, tree_state_ptr, task_state_ptr); });
+        }
+    };
+
+    // * all the nodes of the tree. add new node types here
+    using KiosNodeRegistry = NodeRegistry<
+        // ! the definition of the condition nodes? too many args
+        NodeEntry<HasObject, node_id::kHasObjectApproach, node_id::kApproachObject>,
+        NodeEntry<HasObject, node_id::kHasObjectContact, node_id::kContactObject>,
+        NodeEntry<AtPosition, node_id::kAtPositionApproach, node_id::kApproachObject>,
+        NodeEntry<AtPosition, node_id::kAtPositionContact, node_id::kContactObject>,
+
+        // * demo action nodes
+        NodeEntry<Approach, node_id::kApproach>,
+        NodeEntry<Contact, node_id::kContact>,
+        NodeEntry<Wiggle, node_id::kWiggle>,
+
+        // * general action nodes
+        NodeEntry<CartesianMove, node_id::kCartesianMove>,
+        NodeEntry<JointMove, node_id::kJointMove>,
+        NodeEntry<GripperForce, node_id::kGripperForce>,
+        NodeEntry<GripperMove, node_id::kGripperMove>,
+
+        // * additional
+        NodeEntry<ToolLoad, node_id::kToolLoad>,
+        NodeEntry<ToolUnload, node_id::kToolUnload>,
+        NodeEntry<ToolGrasp, node_id::kToolGrasp>,
+        NodeEntry<ToolRelease, node_id::kToolRelease>,
+        NodeEntry<GripperGrasp, node_id::kGripperGrasp>,
+        NodeEntry<GripperRelease, node_id::kGripperRelease>,
+
+        // * compound
+        NodeEntry<ToolPick, node_id::kToolPick>,
+        NodeEntry<ToolPlace, node_id::kToolPlace>,
+        NodeEntry<GripperPick, node_id::kGripperPick>,
+        NodeEntry<GripperPlace, node_id::kGripperPlace>>;
+
+    inline constexpr std::size_t kKiosNodeTypeCount = KiosNodeRegistry::size;
+
+} // namespace Insertion
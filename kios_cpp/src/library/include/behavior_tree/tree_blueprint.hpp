@@ -0,0 +1,90 @@
+#pragma once
+
+#include <behaviortree_cpp/bt_factory.h>
+#include <behaviortree_cpp/xml_parsing.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "kios_utils/kios_utils.hpp"
+
+namespace Insertion
+{
+    /**
+     * @brief the archive and the grounded objects of an action node.
+     */
+    struct NodeGrounding
+    {
+        kios::NodeArchive archive;
+        std::vector<std::string> object_keys;
+        std::vector<std::string> object_names;
+    };
+
+    /**
+     * @brief a node of the tree as declared in the xml.
+     */
+    struct BlueprintNode
+    {
+        std::string registration_id;
+        std::string path;
+        BT::PortsRemapping input_ports;
+        BT::PortsRemapping output_ports;
+    };
+
+    /**
+     * @brief a parsed and verified tree xml. new trees are instantiated from it without parsing the xml again.
+     * the node manifest and the groundings are recorded from the first tree instantiated from it.
+     */
+    struct TreeBlueprint
+    {
+        std::size_t hash = 0;
+        std::string tree_string;
+        std::unique_ptr<BT::XMLParser> parser;
+
+        // * filled by the first instantiation
+        bool hasManifest = false;
+        // * all the nodes, in the order of Tree::applyVisitor
+        std::vector<BlueprintNode> nodes;
+        // * manifests of the node types used in the tree
+        std::unordered_map<std::string, BT::TreeNodeManifest> manifests;
+
+        // * filled by the first archiving: the action nodes, in the order of Tree::applyVisitor
+        std::optional<std::vector<NodeGrounding>> groundings;
+    };
+
+    /**
+     * @brief least recently used cache of the tree blueprints, keyed by the hash of the tree xml.
+     * the blueprints keep a reference to the factory, clear the cache if the factory goes away or its registrations change.
+     * ! not thread safe.
+     */
+    class TreeBlueprintCache
+    {
+    public:
+        explicit TreeBlueprintCache(std::size_t capacity = 16);
+
+        std::shared_ptr<TreeBlueprint> get_blueprint(const BT::BehaviorTreeFactory &factory, const std::string &tree_string);
+        BT::Tree instantiate(TreeBlueprint &blueprint, BT::Blackboard::Ptr blackboard = BT::Blackboard::create());
+        void clear();
+
+        std::size_t size() const { return lru_list_.size(); }
+        std::uint64_t get_hit_count() const { return hit_count_; }
+        std::uint64_t get_miss_count() const { return miss_count_; }
+
+    private:
+        std::size_t capacity_;
+        // * most recently used first
+        std::list<std::shared_ptr<TreeBlueprint>> lru_list_;
+        std::unordered_multimap<std::size_t, std::list<std::shared_ptr<TreeBlueprint>>::iterator> index_;
+        std::uint64_t hit_count_;
+        std::uint64_t miss_count_;
+
+        void record_manifest(TreeBlueprint &blueprint, BT::Tree &tree);
+        void evict();
+    };
+
+} // namespace Insertion
@@ -1,6 +1,7 @@
 #include <behaviortree_cpp/behavior_tree.h>
 #include <behaviortree_cpp/bt_factory.h>
 
+#include <array>
 #include <string>
 #include <memory>
 
@@ -10,42 +11,39 @@
 
 #include "behavior_tree/meta_node/meta_node.hpp"
 #include "behavior_tree/tree_map.hpp"
+#include "behavior_tree/tree_blueprint.hpp"
 
-// for demo
-#include "behavior_tree/action_node/approach.hpp"
-#include "behavior_tree/action_node/contact.hpp"
-#include "behavior_tree/action_node/wiggle.hpp"
-
-// general action nodes
-#include "behavior_tree/action_node/cartesian_move.h"
-#include "behavior_tree/action_node/joint_move.hpp"
-#include "behavior_tree/action_node/gripper_force.hpp"
-#include "behavior_tree/action_node/gripper_move.hpp"
-
-// additional
-#include "behavior_tree/action_node/tool_load.hpp"
-#include "behavior_tree/action_node/tool_unload.hpp"
-#include "behavior_tree/action_node/tool_grasp.hpp"
-#include "behavior_tree/action_node/tool_release.hpp"
-#include "behavior_tree/action_node/gripper_grasp.hpp"
-#include "behavior_tree/action_node/gripper_release.hpp"
-
-// compound in mios level
-#include "behavior_tree/compound_action_node/tool_pick.hpp"
-#include "behavior_tree/compound_action_node/tool_place.hpp"
-#include "behavior_tree/compound_action_node/gripper_pick.hpp"
-#include "behavior_tree/compound_action_node/gripper_place.hpp"
-
-// ! BBMOD
-
-#include "behavior_tree/condition_node/condition_node.hpp"
+#include "behavior_tree/node_registry.hpp"
 
 // #include "kios_utils/context_manager.hpp"
 #include "kios_utils/kios_utils.hpp"
+#include "kios_utils/worker_pool.hpp"
 
 // BB CODE
 namespace Insertion
 {
+    /**
+     * @brief the result of TreeRoot::update_tree.
+     */
+    struct TreeUpdate
+    {
+        // * action nodes that kept their state from the old tree
+        std::size_t kept_count = 0;
+        // * action nodes of the old tree that are not in the new tree
+        std::size_t removed_count = 0;
+        // * the archives of the new or changed action nodes, in tree order
+        std::vector<kios::NodeArchive> changed_archives;
+    };
+
+    struct TreeStatistics
+    {
+        std::size_t node_count = 0;
+        std::size_t action_node_count = 0;
+        std::size_t succeeded_count = 0;
+        // * number of nodes per type, indexed by the type id of KiosNodeRegistry
+        std::array<std::size_t, kKiosNodeTypeCount> type_counts{};
+    };
+
     class TreeRoot
     {
     public:
@@ -53,31 +51,48 @@ namespace Insertion
         ~TreeRoot();
         bool initialize_tree();
         bool construct_tree(const std::string &tree_string);
+        std::optional<TreeUpdate> update_tree(const std::string &tree_string);
         bool register_nodes();
         std::optional<std::vector<kios::NodeArchive>> archive_nodes();
         bool check_grounded_objects();
+        std::vector<NodeGrounding> collect_groundings();
+        TreeStatistics get_tree_statistics() const;
+        void reset_tree();
 
         BT::NodeStatus tick_once();
         BT::NodeStatus tick_while_running();
         BT::NodeStatus get_tick_result();
         std::shared_ptr<kios::TreeState> get_tree_state_ptr();
         std::shared_ptr<kios::TaskState> get_task_state_ptr();
+        std::shared_ptr<const TreeBlueprint> get_blueprint() const;
+        const TreeBlueprintCache &get_blueprint_cache() const;
 
     private:
         // kios::ContextClerk context_clerk_;
 
         // flag
         bool hasRegisteredNodes;
+        // * the action nodes of the current tree hold their archives
+        bool hasArchivedNodes;
 
         // * BT rel
         BT::BehaviorTreeFactory factory_;
+        // * parsed trees of the recent plans, a re-submitted plan is not parsed again
+        TreeBlueprintCache blueprint_cache_;
+        // * blueprint of the current tree
+        std::shared_ptr<TreeBlueprint> blueprint_;
         BT::Tree tree_;
+        // * the action nodes of tree_ in tree order, built once per construction
+        std::vector<KiosActionNode *> action_nodes_;
+        // * archiving and grounding check of large trees
+        kios::WorkerPool worker_pool_;
 
         // * state rel
         std::shared_ptr<kios::TreeState> tree_state_ptr_;
         std::shared_ptr<kios::TaskState> task_state_ptr_;
 
         void set_log();
+        static std::vector<KiosActionNode *> collect_action_nodes(BT::Tree &tree);
     };
 
 } // namespace Insertion
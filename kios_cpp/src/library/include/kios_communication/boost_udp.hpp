@@ -1,17 +1,31 @@
 #include <string>
 #include <mutex>
 #include <thread>
-#include <queue>
+#include <deque>
+#include <vector>
+#include <map>
+#include <chrono>
 #include <condition_variable>
 #include <atomic>
 #include <iostream>
+#include <functional>
 
 #include <boost/asio.hpp>
 
+#include "kios_communication/spsc_ring.hpp"
+
 namespace kios
 {
     class BTReceiver
     {
+    public:
+        // * udp payload size limit of the receiver, the last byte is kept for '\0'
+        static constexpr std::size_t kMessageSlotSize = 1024;
+        static constexpr std::size_t kMessageRingCapacity = 64;
+        // * max datagrams read at once when several messages are queued in the socket
+        static constexpr std::size_t kReceiveBatchSize = 16;
+        using MessageRing = SpscRing<kMessageSlotSize, kMessageRingCapacity>;
+
     private:
         boost::asio::io_context io_context_;
         boost::asio::ip::udp::socket socket_;
@@ -19,34 +33,112 @@ namespace kios
 
         std::atomic_bool stopThread;
         std::thread receiverThread;
-        std::queue<std::string> messageQueue;
+        // * datagrams that arrive while the ring is full are read here, and dropped if it is still full
+        char overflowBuffer_[kMessageSlotSize];
+        // * socket thread -> consumer thread, no lock and no allocation on the receive path
+        MessageRing messageRing;
+        // * only used by wait_for_message to sleep
         std::mutex mtx;
         std::condition_variable cv;
+        std::atomic_bool hasWaiter;
 
-        void receive_message();
+        std::function<void()> message_callback_;
+        std::mutex callback_mtx;
+
+        void start_receive();
+        void handle_receive(const boost::system::error_code &error, std::size_t length, MessageRing::Slot *slot);
+        std::size_t receive_batch();
+        void notify_consumer();
 
     public:
-        BTReceiver(std::string ip, int port, bool isThreading = true);
+        BTReceiver(std::string ip, int port, bool isThreading = true, RingOverflowPolicy policy = RingOverflowPolicy::DROP_NEWEST);
         ~BTReceiver();
 
         bool get_message(std::string &message);
+        template <typename Visitor>
+        bool consume_message(Visitor &&visitor);
         void wait_for_message(std::string &message);
+        void set_message_callback(std::function<void()> callback);
         void stop_thread();
+
+        std::uint64_t get_overflow_count() const { return messageRing.get_overflow_count(); }
+        std::uint64_t get_overwritten_count() const { return messageRing.get_overwritten_count(); }
+        std::uint64_t get_received_count() const { return messageRing.get_pushed_count(); }
+    };
+
+    /**
+     * @brief read the next message in place (no copy) and release it.
+     *
+     * @param visitor called as visitor(const char *data, std::size_t length), data is '\0' terminated.
+     * @return true if a message was consumed
+     */
+    template <typename Visitor>
+    bool BTReceiver::consume_message(Visitor &&visitor)
+    {
+        const MessageRing::Slot *slot = messageRing.front();
+        if (slot == nullptr)
+        {
+            return false;
+        }
+        visitor(static_cast<const char *>(slot->data), slot->length);
+        messageRing.pop();
+        return true;
+    }
+
+    /**
+     * @brief send statistics of one target endpoint of BTSender.
+     */
+    struct SendStatistics
+    {
+        std::uint64_t messages_sent = 0;
+        std::uint64_t bytes_sent = 0;
+        std::uint64_t send_errors = 0;
     };
 
     class BTSender
     {
+    public:
+        // * max datagrams handed to the kernel in one call
+        static constexpr std::size_t kSendBatchSize = 32;
+
     private:
+        struct OutgoingMessage
+        {
+            std::string payload;
+            boost::asio::ip::udp::endpoint endpoint;
+        };
+
         boost::asio::io_context io_context_;
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work_guard_;
         boost::asio::ip::udp::socket socket_;
         boost::asio::ip::udp::endpoint target_endpoint_;
+        boost::asio::steady_timer rate_timer_;
 
         std::atomic_bool stopThread;
         std::thread senderThread;
-        std::queue<std::string> messageQueue;
+
+        // * producer side. the strings are moved in and out, never copied.
+        std::deque<OutgoingMessage> messageQueue;
         std::mutex mtx;
+        bool isFlushScheduled;
 
-        void send_message();
+        // * only touched in the sender thread
+        std::vector<OutgoingMessage> sendingBatch_;
+        bool isWaitingForRate_;
+
+        // * token bucket, messages per second. 0 means no limit.
+        double rate_limit_;
+        double rate_tokens_;
+        std::chrono::steady_clock::time_point rate_last_refill_;
+
+        std::map<boost::asio::ip::udp::endpoint, SendStatistics> statistics_;
+        std::mutex statistics_mtx;
+        std::atomic<std::uint64_t> batchCount;
+
+        void schedule_flush();
+        void flush();
+        std::size_t take_rate_tokens(std::size_t requested);
+        std::size_t send_batch(std::size_t count);
 
     public:
         BTSender(std::string ip, int port, bool isThreading = true);
@@ -56,6 +148,11 @@ namespace kios
         bool start();
 
         void push_message(std::string &&message);
+        void push_message(std::string &&message, const boost::asio::ip::udp::endpoint &endpoint);
+
+        void set_rate_limit(double messages_per_second);
+        std::map<boost::asio::ip::udp::endpoint, SendStatistics> get_statistics();
+        std::uint64_t get_batch_count() const { return batchCount.load(); }
 
         void stop_thread();
     };
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace kios
+{
+    /**
+     * @brief what the consumer gets from the ring.
+     * DROP_NEWEST: fifo. when the ring is full the new message is dropped and counted as overflow.
+     * LATEST_WINS: the consumer always gets the newest message, the older ones are skipped and counted.
+     *              when the ring is full the producer overwrites the oldest message, the new one is kept.
+     */
+    enum class RingOverflowPolicy
+    {
+        DROP_NEWEST = 0,
+        LATEST_WINS = 1,
+    };
+
+    /**
+     * @brief preallocated fixed-size message slot.
+     *
+     * @tparam SlotSize max size of a message in bytes, including the terminating '\0'.
+     */
+    template <std::size_t SlotSize>
+    struct MessageSlot
+    {
+        std::size_t length = 0;
+        char data[SlotSize];
+    };
+
+    /**
+     * @brief bounded lock-free single-producer/single-consumer ring of fixed-size message slots.
+     * no allocation after construction. the producer writes directly into the slot (e.g. from the socket)
+     * and commits it, the consumer reads the slot in place and releases it.
+     * ! only ONE producer thread and ONE consumer thread are allowed.
+     * with LATEST_WINS the producer and the consumer both move the tail (compare-exchange), and the slot
+     * the consumer is reading is never reused until it is released. one slot is kept free for it.
+     *
+     * @tparam SlotSize max message size in bytes
+     * @tparam Capacity number of slots, must be a power of two
+     */
+    template <std::size_t SlotSize, std::size_t Capacity>
+    class SpscRing
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing: Capacity must be a power of two.");
+        static_assert(SlotSize >= 2, "SpscRing: SlotSize is too small.");
+
+    public:
+        using Slot = MessageSlot<SlotSize>;
+
+        explicit SpscRing(RingOverflowPolicy policy = RingOverflowPolicy::DROP_NEWEST)
+            : policy_(policy),
+              head_(0),
+              tail_(0),
+              reading_(kNotReading),
+              overflow_count_(0),
+              overwritten_count_(0),
+              pushed_count_(0)
+        {
+        }
+
+        SpscRing(const SpscRing &) = delete;
+        SpscRing &operator=(const SpscRing &) = delete;
+
+        static constexpr std::size_t slot_size() { return SlotSize; }
+        static constexpr std::size_t capacity() { return Capacity; }
+
+        ////////////////////////////// producer side //////////////////////////////
+
+        /**
+         * @brief get the next free slot to write into. nullptr if the ring is full.
+         * with LATEST_WINS the oldest unread message is dropped to make room instead.
+         */
+        Slot *acquire_write_slot()
+        {
+            return acquire_write_slot(0);
+        }
+
+        /**
+         * @brief get the n-th free slot after the next one, for batched writing. nullptr if not free.
+         */
+        Slot *acquire_write_slot(std::size_t offset)
+        {
+            const std::size_t committed = head_.load(std::memory_order_relaxed);
+            const std::size_t head = committed + offset;
+            if (policy_ == RingOverflowPolicy::DROP_NEWEST)
+            {
+                if (head - tail_.load(std::memory_order_acquire) >= Capacity)
+                {
+                    return nullptr;
+                }
+                return &slots_[head & (Capacity - 1)];
+            }
+
+            std::size_t tail = tail_.load(std::memory_order_seq_cst);
+            // * the slot is the one the consumer is still reading: fail before dropping anything,
+            // * a new arrival costs at most one message. a slot the consumer takes after this load is
+            // * newer than the tail loaded above and never the one written here.
+            const std::size_t reading = reading_.load(std::memory_order_seq_cst);
+            if (reading != kNotReading && head - reading >= Capacity)
+            {
+                return nullptr;
+            }
+            while (head - tail >= Capacity - 1)
+            {
+                if (tail == committed)
+                {
+                    // * all the slots are already taken by this batch
+                    return nullptr;
+                }
+                // * drop the oldest committed message. fails if the consumer moved the tail meanwhile.
+                if (tail_.compare_exchange_weak(tail, tail + 1, std::memory_order_seq_cst))
+                {
+                    overwritten_count_.fetch_add(1, std::memory_order_relaxed);
+                    tail++;
+                }
+            }
+            return &slots_[head & (Capacity - 1)];
+        }
+
+        /**
+         * @brief publish the slot(s) acquired with acquire_write_slot to the consumer.
+         */
+        void commit_write(std::size_t count = 1)
+        {
+            pushed_count_.fetch_add(count, std::memory_order_relaxed);
+            head_.store(head_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+        /**
+         * @brief the producer lost a message because the ring was full.
+         */
+        void record_overflow()
+        {
+            overflow_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief copy a message into the ring. the message is truncated to SlotSize - 1.
+         *
+         * @return false if the ring is full (message dropped)
+         */
+        bool push(const char *data, std::size_t length)
+        {
+            Slot *slot = acquire_write_slot();
+            if (slot == nullptr)
+            {
+                record_overflow();
+                return false;
+            }
+            if (length > SlotSize - 1)
+            {
+                length = SlotSize - 1;
+            }
+            std::memcpy(slot->data, data, length);
+            slot->data[length] = '\0';
+            slot->length = length;
+            commit_write();
+            return true;
+        }
+
+        ////////////////////////////// consumer side //////////////////////////////
+
+        /**
+         * @brief the slot to read according to the policy. nullptr if the ring is empty.
+         * with LATEST_WINS the newest slot is taken and all the older ones are released here.
+         */
+        const Slot *front()
+        {
+            if (policy_ == RingOverflowPolicy::DROP_NEWEST)
+            {
+                const std::size_t tail = tail_.load(std::memory_order_relaxed);
+                if (head_.load(std::memory_order_acquire) == tail)
+                {
+                    return nullptr;
+                }
+                return &slots_[tail & (Capacity - 1)];
+            }
+
+            std::size_t tail = tail_.load(std::memory_order_seq_cst);
+            while (true)
+            {
+                const std::size_t head = head_.load(std::memory_order_acquire);
+                if (head == tail)
+                {
+                    reading_.store(kNotReading, std::memory_order_release);
+                    return nullptr;
+                }
+                // * announce the slot before taking it, the producer checks it after moving the tail
+                reading_.store(head - 1, std::memory_order_seq_cst);
+                if (tail_.compare_exchange_weak(tail, head, std::memory_order_seq_cst))
+                {
+                    overwritten_count_.fetch_add(head - 1 - tail, std::memory_order_relaxed);
+                    return &slots_[(head - 1) & (Capacity - 1)];
+                }
+            }
+        }
+
+        /**
+         * @brief release the slot returned by front().
+         */
+        void pop()
+        {
+            if (policy_ == RingOverflowPolicy::DROP_NEWEST)
+            {
+                tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            }
+            else
+            {
+                // * the tail is already past the slot
+                reading_.store(kNotReading, std::memory_order_release);
+            }
+        }
+
+        /**
+         * @brief copy the next message out and release its slot. the string keeps its capacity.
+         *
+         * @return false if the ring is empty
+         */
+        bool pop(std::string &message)
+        {
+            const Slot *slot = front();
+            if (slot == nullptr)
+            {
+                return false;
+            }
+            message.assign(slot->data, slot->length);
+            pop();
+            return true;
+        }
+
+        bool empty() const
+        {
+            return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+        }
+
+        std::size_t size() const
+        {
+            return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+        }
+
+        ////////////////////////////// statistics //////////////////////////////
+
+        RingOverflowPolicy get_policy() const { return policy_; }
+        std::uint64_t get_overflow_count() const { return overflow_count_.load(std::memory_order_relaxed); }
+        std::uint64_t get_overwritten_count() const { return overwritten_count_.load(std::memory_order_relaxed); }
+        std::uint64_t get_pushed_count() const { return pushed_count_.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr std::size_t kNotReading = std::numeric_limits<std::size_t>::max();
+
+        const RingOverflowPolicy policy_;
+
+        // * separate cache lines for the producer and the consumer index
+        alignas(64) std::atomic<std::size_t> head_; // written by producer
+        alignas(64) std::atomic<std::size_t> tail_; // written by consumer (and by producer with LATEST_WINS)
+        std::atomic<std::size_t> reading_;          // LATEST_WINS: the slot the consumer holds
+
+        alignas(64) std::atomic<std::uint64_t> overflow_count_;
+        std::atomic<std::uint64_t> overwritten_count_;
+        std::atomic<std::uint64_t> pushed_count_;
+
+        std::array<Slot, Capacity> slots_;
+    };
+} // namespace kios
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace kios
+{
+    /**
+     * @brief the fields of the mios udp telemetry (see Commander::mios_register_udp).
+     */
+    enum TelemetryField : std::uint32_t
+    {
+        TELEMETRY_TF_F_EXT_K = 1u << 0,
+        TELEMETRY_T_T_EE = 1u << 1,
+        TELEMETRY_TAU_EXT = 1u << 2,
+        TELEMETRY_Q = 1u << 3,
+        TELEMETRY_SYSTEM_TIME = 1u << 4,
+    };
+
+    /**
+     * @brief one decoded mios telemetry datagram. fixed size, no allocation.
+     * field_mask tells which fields were found with the expected size in the last decoded datagram.
+     */
+    struct MiosTelemetry
+    {
+        std::array<double, 6> tf_f_ext_k = {0, 0, 0, 0, 0, 0};
+        std::array<double, 16> t_t_ee = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        std::array<double, 7> tau_ext = {0, 0, 0, 0, 0, 0, 0};
+        std::array<double, 7> q = {0, 0, 0, 0, 0, 0, 0};
+        double system_time = 0;
+        std::uint32_t field_mask = 0;
+
+        bool has(TelemetryField field) const { return (field_mask & field) != 0; }
+    };
+
+    /**
+     * @brief decode a mios telemetry datagram (json) in place, without building a json document or any string.
+     * the keys are searched at any nesting level, unknown keys are skipped.
+     * ! data must be '\0' terminated at length, as the slots of BTReceiver are.
+     *
+     * @param data
+     * @param length
+     * @param telemetry output. only the found fields are overwritten, field_mask is reset.
+     * @return true if at least one known field was decoded
+     */
+    bool decode_mios_telemetry(const char *data, std::size_t length, MiosTelemetry &telemetry);
+} // namespace kios
@@ -19,18 +19,26 @@
 #include <map>
 #include <string>
 #include <typeinfo>
+#include <vector>
 
+#include <array>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
 #include <queue>
 #include <chrono>
 #include <optional>
+#include <future>
+#include <atomic>
+#include <cstdint>
 
 // Define types for convenience
 typedef websocketpp::client<websocketpp::config::asio_client> client;
 typedef websocketpp::lib::shared_ptr<websocketpp::lib::thread> thread_ptr;
 
+/**
+ * @brief bounded blocking queue. when full, the new element is dropped and counted, the queued ones are never discarded.
+ */
 template <typename T>
 class ThreadSafeQueue
 {
@@ -38,13 +46,32 @@ private:
     std::queue<T> queue;
     std::mutex mtx;
     std::condition_variable cv;
+    std::size_t capacity;
+    std::uint64_t pushed_count;
+    std::uint64_t dropped_count;
 
 public:
-    void push(const T &value)
+    explicit ThreadSafeQueue(std::size_t capacity = 64)
+        : capacity(capacity), pushed_count(0), dropped_count(0)
+    {}
+
+    /**
+     * @brief
+     *
+     * @return false if the queue is full and the value is dropped
+     */
+    bool push(const T &value)
     {
         std::lock_guard<std::mutex> lock(mtx);
+        if (queue.size() >= capacity)
+        {
+            dropped_count++;
+            return false;
+        }
         queue.push(value);
+        pushed_count++;
         cv.notify_one(); // Notify a waiting thread, if any
+        return true;
     }
 
     std::optional<T> pop(int wait_deadline = 1000)
@@ -66,14 +93,53 @@ public:
         }
     }
 
-    void reset()
+    std::optional<T> try_pop()
     {
-        std::unique_lock<std::mutex> lock(mtx);
-        std::queue<T> empty_queue;
-        queue.swap(empty_queue);
+        std::lock_guard<std::mutex> lock(mtx);
+        if (queue.empty())
+        {
+            return std::nullopt;
+        }
+        T value = queue.front();
+        queue.pop();
+        return value;
+    }
+
+    std::size_t size()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return queue.size();
+    }
+
+    std::uint64_t get_pushed_count()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return pushed_count;
+    }
+
+    std::uint64_t get_dropped_count()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return dropped_count;
     }
 };
 
+/**
+ * @brief inbound channels of the mios messages that do not complete a pending call, i.e. unsolicited messages.
+ * late responses to cancelled calls are dropped, not queued. each channel has its own bounded queue,
+ * a slow consumer of one channel does not block the others.
+ */
+enum class MiosChannel : std::size_t
+{
+    TASK_RESULT = 0,   // start_and_monitor, wait_for_task
+    COMMAND_ACK = 1,   // start_task, stop_task, teach_object, ... and messages of unknown origin
+    TELEMETRY_ACK = 2, // subscribe_telemetry, unsubscribe_telemetry
+};
+constexpr std::size_t kMiosChannelCount = 3;
+
+MiosChannel get_mios_channel(const std::string &method);
+const char *get_mios_channel_name(MiosChannel channel);
+
 // Class to hold connection metadata
 class connection_metadata
 {
@@ -127,12 +193,37 @@ class websocket_endpoint
     // Counter to generate unique IDs for connections
     int m_next_id;
     // concurrency
-    ThreadSafeQueue<std::string> message_queue_;
+    // * messages that do not complete any pending call, per channel
+    std::array<ThreadSafeQueue<std::string>, kMiosChannelCount> inbound_channels_;
+
+    // * calls waiting for their response, keyed by request id
+    struct PendingCall
+    {
+        std::string method;
+        // * long running calls (start_and_monitor, wait_for_task) answer late on TASK_RESULT
+        MiosChannel channel = MiosChannel::COMMAND_ACK;
+        std::promise<std::optional<nlohmann::json>> promise;
+        // * if set, called in the websocket thread instead of fulfilling the promise
+        std::function<void(std::optional<nlohmann::json>)> callback;
+    };
+
+    void complete_call(PendingCall &call, std::optional<nlohmann::json> &&response);
+    void on_connection_lost(connection_metadata::ptr metadata, websocketpp::connection_hdl hdl, bool isFailed);
+    std::map<std::uint64_t, PendingCall> pending_calls_;
+    std::mutex pending_mtx_;
+    std::uint64_t m_next_request_id;
+    // * request id -> channel of the cancelled calls, their late responses are dropped
+    std::map<std::uint64_t, MiosChannel> cancelled_calls_;
+    static constexpr std::size_t kMaxCancelledCalls = 256;
+
+    void push_inbound(MiosChannel channel, const std::string &message);
 
 public:
     // Constructor
     websocket_endpoint()
-        : m_next_id(0)
+        : m_next_id(0),
+          inbound_channels_{ThreadSafeQueue<std::string>(64), ThreadSafeQueue<std::string>(64), ThreadSafeQueue<std::string>(16)},
+          m_next_request_id(1)
     {
         // Set logging to be pretty verbose (everything except message payloads)
         m_endpoint.clear_access_channels(websocketpp::log::alevel::all);
@@ -155,7 +246,7 @@ public:
 
     bool is_open(int connection_id);
 
-    void send(int id, const std::string &message);
+    bool send(int id, const std::string &message);
 
     connection_metadata::ptr get_metadata(int id);
 
@@ -166,11 +257,28 @@ public:
 
     void message_handler_callback(websocketpp::connection_hdl hdl, client::message_ptr msg);
 
-    ThreadSafeQueue<std::string> &get_message_queue();
+    ThreadSafeQueue<std::string> &get_inbound_channel(MiosChannel channel);
+
+    std::uint64_t register_call(const std::string &method, bool isMonitoring, std::future<std::optional<nlohmann::json>> &future);
+    std::uint64_t register_call(const std::string &method, bool isMonitoring, std::function<void(std::optional<nlohmann::json>)> callback);
+    bool cancel_call(std::uint64_t request_id);
+    bool fail_call(std::uint64_t request_id);
+    std::size_t fail_all_calls();
+    std::size_t get_pending_call_count();
+};
 
-    void reset_message_queue();
+/**
+ * @brief handle of an in-flight mios call.
+ */
+struct PendingCallHandle
+{
+    std::uint64_t request_id = 0;
+    std::future<std::optional<nlohmann::json>> result;
 };
 
+// * called with the mios response, std::nullopt if the call is cancelled or failed
+using CallResultCallback = std::function<void(std::optional<nlohmann::json>)>;
+
 class BTMessenger
 {
 public:
@@ -181,6 +289,18 @@ public:
     void send(const std::string &method, nlohmann::json payload = nlohmann::json(), int timeout = 100, bool silent = false);
     void send_and_wait(const std::string &method, nlohmann::json payload = nlohmann::json(), int timeout = 100, bool silent = false);
     std::optional<nlohmann::json> send_and_check(const std::string &method, nlohmann::json payload = nlohmann::json(), int timeout = 1000, bool silent = false);
+    PendingCallHandle call_async(const std::string &method, const nlohmann::json &payload = nlohmann::json(), bool isMonitoring = false);
+    std::uint64_t call_async(const std::string &method, const nlohmann::json &payload, bool isMonitoring, CallResultCallback callback);
+    std::optional<nlohmann::json> wait_for_call(PendingCallHandle &handle, int timeout);
+    bool cancel_call(std::uint64_t request_id);
+    ThreadSafeQueue<std::string> &get_inbound_channel(MiosChannel channel);
+    // completion based task api
+    std::uint64_t start_and_monitor_async(const nlohmann::json &skill_context, const std::string &skill_type, CallResultCallback callback);
+    std::uint64_t wait_for_task_result_async(int task_uuid, CallResultCallback callback);
+    PendingCallHandle wait_for_task_result_async(int task_uuid);
+    bool cancel_task_wait(int task_uuid);
+    // task envelope templates
+    void prepare_task_templates(const std::vector<std::string> &skill_types);
     void close();
     bool is_connected();
     // call mios methods
@@ -191,6 +311,8 @@ public:
     void stop_task_command();
     std::optional<nlohmann::json> stop_task_request();
     std::optional<nlohmann::json> start_task_request(nlohmann::json skill_context, std::string skill_type);
+    PendingCallHandle stop_task_async();
+    PendingCallHandle start_task_async(const nlohmann::json &skill_context, const std::string &skill_type);
     void unregister_udp();
     void register_udp(int &port, nlohmann::json &sub_list);
     void set_message_handler(std::function<void(const std::string &)> handler);
@@ -209,4 +331,31 @@ private:
     std::mutex mutex_;
     std::queue<std::string> message_queue_;
     std::condition_variable cv_;
+    // * task uuid -> request id of the pending wait_for_task call
+    std::map<int, std::uint64_t> task_waits_;
+    std::mutex task_waits_mtx_;
+
+    /**
+     * @brief serialized call frame of a GenericTask with one skill, split around the skill context.
+     * frame = prefix + skill_context.dump() + suffix + request id + "}"
+     */
+    struct TaskEnvelope
+    {
+        std::string prefix;
+        std::string suffix;
+    };
+    // * key: method + "/" + skill_type
+    std::map<std::string, TaskEnvelope> task_templates_;
+    std::mutex task_templates_mtx_;
+
+    nlohmann::json make_task_context(const nlohmann::json &skill_context, const std::string &skill_type);
+    TaskEnvelope make_task_envelope(const std::string &method, const std::string &skill_type);
+    std::string make_task_frame(const std::string &method, const nlohmann::json &skill_context, const std::string &skill_type, std::uint64_t request_id);
+    std::optional<nlohmann::json> wait_interruptible(PendingCallHandle &handle, std::atomic_bool &isInterrupted);
+    bool send_call(std::uint64_t request_id, const std::string &frame);
+    std::string make_call_frame(const std::string &method, const nlohmann::json &payload, std::uint64_t request_id);
+    void forget_task_wait(int task_uuid, const std::shared_ptr<std::uint64_t> &request_id_ptr);
+
+    // * how often the blocking task waits look at their interrupt flag
+    static constexpr std::chrono::milliseconds kInterruptCheckPeriod{5};
 };
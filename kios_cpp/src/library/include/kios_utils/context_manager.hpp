@@ -5,6 +5,7 @@
 #include <fstream>
 #include <memory>
 #include <filesystem>
+#include <cstdint>
 #include "kios_utils/logger_setting.hpp"
 
 namespace kios
@@ -20,6 +21,9 @@ namespace kios
 
         nlohmann::json get_context(const NodeArchive &archive) const;
 
+        // * bumped whenever the archived contexts change
+        std::uint64_t get_context_version() const;
+
     private:
         std::shared_ptr<spdlog::logger> logger;
 
@@ -30,5 +34,7 @@ namespace kios
         std::unique_ptr<DefaultActionContext> default_context_dictionary_ptr_;
 
         std::unordered_map<int, std::unordered_map<int, std::pair<std::string, nlohmann::json>>> action_ground_dictionary_;
+
+        std::uint64_t context_version_;
     };
 } // namespace kios
@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
@@ -14,9 +16,14 @@
 #include "kios_interface/msg/task_state.hpp"
 #include "kios_interface/msg/mios_state.hpp"
 #include "kios_interface/msg/sensor_state.hpp"
+#include "kios_interface/msg/task_state_fixed.hpp"
+#include "kios_interface/msg/mios_state_fixed.hpp"
+#include "kios_interface/msg/sensor_state_fixed.hpp"
+#include "kios_interface/msg/telemetry_window.hpp"
 #include "kios_interface/msg/node_archive.hpp"
 
 #include "mirmi_utils/math.hpp"
+#include "kios_utils/telemetry_history.hpp"
 
 #include "spdlog/spdlog.h"
 
@@ -159,36 +166,122 @@ namespace kios
         bool isSucceeded = false;
     };
 
+    /**
+     * @brief the robot state from mios. fixed size, updating it from a message copies the values in place
+     * and never allocates.
+     * t_t_ee_matrix is column major, the same order as the 16 values of T_T_EE sent by mios.
+     */
     struct MiosState
     {
-        std::vector<double> tf_f_ext_k = {0, 0, 0, 0, 0, 0};
-        std::vector<double> t_t_ee = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-        Eigen::Matrix<double, 4, 4> t_t_ee_matrix;
+        Eigen::Matrix<double, 6, 1> tf_f_ext_k = Eigen::Matrix<double, 6, 1>::Zero();
+        Eigen::Matrix<double, 4, 4> t_t_ee_matrix = Eigen::Matrix<double, 4, 4>::Zero();
 
-        void from_ros2_msg(const kios_interface::msg::MiosState &msg)
+        /**
+         * @brief the message fields are unbounded sequences. a message with a field of unexpected size is rejected
+         * as a whole and nothing is copied.
+         * ! the state may be a back buffer holding an older state, don't publish it if this fails.
+         *
+         * @return false if the message is malformed
+         */
+        bool from_ros2_msg(const kios_interface::msg::MiosState &msg)
         {
-            tf_f_ext_k = std::move(msg.tf_f_ext_k);
-            if (msg.t_t_ee.size() != 16)
+            if (msg.tf_f_ext_k.size() != 6 || msg.t_t_ee.size() != 16)
             {
                 std::cerr << "Invalid data size!" << std::endl;
+                return false;
             }
-            else
+            tf_f_ext_k = Eigen::Map<const Eigen::Matrix<double, 6, 1>>(msg.tf_f_ext_k.data());
+            t_t_ee_matrix = Eigen::Map<const Eigen::Matrix<double, 4, 4>>(msg.t_t_ee.data());
+            return true;
+        }
+
+        /**
+         * @brief fixed-size message version. the size is guaranteed by the type, no check.
+         */
+        void from_ros2_msg(const kios_interface::msg::MiosStateFixed &msg)
+        {
+            tf_f_ext_k = Eigen::Map<const Eigen::Matrix<double, 6, 1>>(msg.tf_f_ext_k.data());
+            t_t_ee_matrix = Eigen::Map<const Eigen::Matrix<double, 4, 4>>(msg.t_t_ee.data());
+        }
+    };
+
+    struct SensorState
+    {
+        std::array<double, 6> test_data = {0, 0, 0, 0, 0, 0};
+
+        /**
+         * @brief same as MiosState, a malformed message is rejected.
+         *
+         * @return false if the message is malformed
+         */
+        bool from_ros2_msg(const kios_interface::msg::SensorState &msg)
+        {
+            if (msg.test_data.size() != test_data.size())
             {
-                // * Here move
-                t_t_ee = std::move(msg.t_t_ee);
-                // * Here copy
-                t_t_ee_matrix = Eigen::Map<Eigen::Matrix<double, 4, 4>>(t_t_ee.data());
+                std::cerr << "Invalid data size!" << std::endl;
+                return false;
             }
+            std::copy(msg.test_data.begin(), msg.test_data.end(), test_data.begin());
+            return true;
+        }
+
+        void from_ros2_msg(const kios_interface::msg::SensorStateFixed &msg)
+        {
+            test_data = msg.test_data;
         }
     };
 
-    struct SensorState
+    inline kios_interface::msg::TelemetryWindow telemetry_window_to_ros2_msg(const TelemetryWindow &window)
     {
-        std::vector<double> test_data = {0, 0, 0, 0, 0, 0};
+        kios_interface::msg::TelemetryWindow msg;
+        msg.sample_count = window.sample_count;
+        msg.window_duration = window.window_duration;
+        msg.tf_f_ext_k_max_abs = window.tf_f_ext_k_max_abs;
+        msg.tf_f_ext_k_mean = window.tf_f_ext_k_mean;
+        msg.tf_f_ext_k_last = window.tf_f_ext_k_last;
+        msg.f_ext_max_norm = window.f_ext_max_norm;
+        return msg;
+    }
+
+    inline TelemetryWindow telemetry_window_from_ros2_msg(const kios_interface::msg::TelemetryWindow &msg)
+    {
+        TelemetryWindow window;
+        window.sample_count = msg.sample_count;
+        window.window_duration = msg.window_duration;
+        window.tf_f_ext_k_max_abs = msg.tf_f_ext_k_max_abs;
+        window.tf_f_ext_k_mean = msg.tf_f_ext_k_mean;
+        window.tf_f_ext_k_last = msg.tf_f_ext_k_last;
+        window.f_ext_max_norm = msg.f_ext_max_norm;
+        return window;
+    }
+
+    /**
+     * @brief the part of the task state published by the messenger. snapshot passed from the subscription to the tick.
+     */
+    struct PerceptionState
+    {
+        MiosState mios_state;
+        SensorState sensor_state;
+        TelemetryWindow telemetry;
+
+        /**
+         * @return false if the message is malformed, the state is then partly updated
+         */
+        bool from_ros2_msg(const kios_interface::msg::TaskState &msg)
+        {
+            if (!mios_state.from_ros2_msg(msg.mios_state) || !sensor_state.from_ros2_msg(msg.sensor_state))
+            {
+                return false;
+            }
+            telemetry = telemetry_window_from_ros2_msg(msg.telemetry);
+            return true;
+        }
 
-        void from_ros2_msg(const kios_interface::msg::SensorState &msg)
+        void from_ros2_msg(const kios_interface::msg::TaskStateFixed &msg)
         {
-            test_data = std::move(msg.test_data);
+            mios_state.from_ros2_msg(msg.mios_state);
+            sensor_state.from_ros2_msg(msg.sensor_state);
+            telemetry = telemetry_window_from_ros2_msg(msg.telemetry);
         }
     };
 
@@ -201,11 +294,27 @@ namespace kios
         // * from messenger
         MiosState mios_state;
         SensorState sensor_state;
+        // * wrench samples since the last publish, mios_state only holds the last one
+        TelemetryWindow telemetry;
+
+        /**
+         * @return false if the message is malformed, the state is then partly updated
+         */
+        bool from_ros2_msg(const kios_interface::msg::TaskState &msg)
+        {
+            if (!mios_state.from_ros2_msg(msg.mios_state) || !sensor_state.from_ros2_msg(msg.sensor_state))
+            {
+                return false;
+            }
+            telemetry = telemetry_window_from_ros2_msg(msg.telemetry);
+            return true;
+        }
 
-        void from_ros2_msg(const kios_interface::msg::TaskState &msg)
+        void from_ros2_msg(const kios_interface::msg::TaskStateFixed &msg)
         {
             mios_state.from_ros2_msg(msg.mios_state);
             sensor_state.from_ros2_msg(msg.sensor_state);
+            telemetry = telemetry_window_from_ros2_msg(msg.telemetry);
         }
 
         // * from skill udp
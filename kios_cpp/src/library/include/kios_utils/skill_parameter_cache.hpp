@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "kios_utils/data_type.hpp"
+
+namespace kios
+{
+    /**
+     * @brief skill parameter fetched from the tactician, in the encoding it was sent (cbor or json text).
+     */
+    struct CachedSkillParameter
+    {
+        std::uint64_t context_version = 0;
+        std::vector<uint8_t> cbor;
+        std::string json;
+    };
+
+    /**
+     * @brief local cache of the fetched skill parameters in tree node.
+     * key: action group, action id and the grounded object names of the action node.
+     * an entry is only valid for the context version it was fetched with. the tactician bumps the
+     * version whenever its ContextClerk changes.
+     */
+    class SkillParameterCache
+    {
+    public:
+        SkillParameterCache();
+
+        bool lookup(const NodeArchive &archive, const std::vector<std::string> &object_names, std::uint64_t context_version, CachedSkillParameter &parameter);
+        void store(const NodeArchive &archive, const std::vector<std::string> &object_names, const CachedSkillParameter &parameter);
+        void invalidate(std::uint64_t context_version);
+        void clear();
+
+        std::size_t size();
+        std::uint64_t get_hit_count();
+        std::uint64_t get_miss_count();
+
+    private:
+        using Key = std::tuple<int, int, std::vector<std::string>>;
+
+        std::map<Key, CachedSkillParameter> cache_;
+        std::mutex mtx;
+
+        std::uint64_t hit_count_;
+        std::uint64_t miss_count_;
+    };
+} // namespace kios
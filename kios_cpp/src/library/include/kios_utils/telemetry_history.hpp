@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace kios
+{
+    /**
+     * @brief aggregates of the external wrench (TF_F_ext_K) over the recent samples.
+     * lets the condition nodes see force transients that arrive between two task state publishes.
+     */
+    struct TelemetryWindow
+    {
+        std::uint32_t sample_count = 0;
+        double window_duration = 0; // sec, from the oldest to the newest sample in the window
+        std::array<double, 6> tf_f_ext_k_max_abs = {0, 0, 0, 0, 0, 0};
+        std::array<double, 6> tf_f_ext_k_mean = {0, 0, 0, 0, 0, 0};
+        std::array<double, 6> tf_f_ext_k_last = {0, 0, 0, 0, 0, 0};
+        double f_ext_max_norm = 0; // max norm of the force part (first three components)
+    };
+
+    /**
+     * @brief combine two consecutive windows, e.g. of two publishes the reader has not seen yet.
+     * the peaks are exact, the mean and the sample count assume the windows do not overlap.
+     */
+    TelemetryWindow merge_telemetry_windows(const TelemetryWindow &older, const TelemetryWindow &newer);
+
+    /**
+     * @brief preallocated ring buffer of time stamped wrench samples. the oldest sample is overwritten
+     * when the buffer is full. no allocation after construction.
+     * ! not thread safe. one thread at a time per instance, the owner provides the synchronisation
+     * (e.g. the messenger locks it between the socket thread and the publish timer).
+     */
+    class TelemetryHistory
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        struct Sample
+        {
+            Clock::time_point stamp;
+            std::array<double, 6> tf_f_ext_k;
+        };
+
+        explicit TelemetryHistory(std::size_t depth = 256);
+
+        void push(const double *tf_f_ext_k, std::size_t size, Clock::time_point stamp = Clock::now());
+        TelemetryWindow aggregate(std::chrono::milliseconds window, Clock::time_point now = Clock::now()) const;
+        void clear();
+
+        std::size_t depth() const;
+        std::size_t size() const;
+        std::uint64_t get_pushed_count() const;
+
+    private:
+        std::vector<Sample> samples_;
+        std::size_t head_;  // next slot to write
+        std::size_t count_; // valid samples
+        std::uint64_t pushed_count_;
+    };
+} // namespace kios
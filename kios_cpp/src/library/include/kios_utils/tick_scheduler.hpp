@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace kios
+{
+    /**
+     * @brief event driven tick scheduler. the tick callback is run in a dedicated thread as soon as an event
+     * is notified (udp phase message, task state update, service reply...). if nothing happens the tick falls
+     * back to the max tick period.
+     */
+    class TickScheduler
+    {
+    public:
+        TickScheduler(std::function<void()> tick_callback, std::chrono::milliseconds max_tick_period = std::chrono::milliseconds(100));
+        ~TickScheduler();
+
+        bool start();
+        void stop();
+        bool is_running();
+
+        // * wake up the tick thread. can be called from any thread.
+        void notify();
+
+        void set_max_tick_period(std::chrono::milliseconds max_tick_period);
+        std::chrono::milliseconds get_max_tick_period();
+
+    private:
+        std::function<void()> tick_callback_;
+        std::chrono::milliseconds max_tick_period_;
+
+        std::atomic_bool stopThread;
+        std::thread tickThread;
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool hasPendingEvent;
+
+        void tick_loop();
+    };
+} // namespace kios
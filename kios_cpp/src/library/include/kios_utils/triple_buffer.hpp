@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace kios
+{
+    /**
+     * @brief lock-free triple buffer for passing the latest state from one producer thread to one consumer thread.
+     * the producer writes into its own back buffer and publishes it, the consumer swaps in the newest published
+     * buffer and reads it in place. neither side ever waits for the other. a state published twice before the
+     * consumer picks it up is overwritten by the newer one (latest wins).
+     * ! only ONE producer thread and ONE consumer thread are allowed.
+     * ! the back buffer is not cleared: it holds an older state, the producer must write all the fields it owns.
+     *
+     * @tparam T default constructible
+     */
+    template <typename T>
+    class TripleBuffer
+    {
+    public:
+        TripleBuffer()
+            : back_(0),
+              middle_(1),
+              front_(2),
+              published_count_(0)
+        {
+        }
+
+        TripleBuffer(const TripleBuffer &) = delete;
+        TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+        ////////////////////////////// producer side //////////////////////////////
+
+        /**
+         * @brief the buffer to fill before publish().
+         */
+        T &write_buffer()
+        {
+            return slots_[back_].value;
+        }
+
+        /**
+         * @brief hand the back buffer over to the consumer. the producer gets the former middle buffer.
+         */
+        void publish()
+        {
+            const std::uint8_t previous = middle_.exchange(back_ | kDirty, std::memory_order_acq_rel);
+            back_ = previous & kIndexMask;
+            published_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief true if the consumer has not taken the last published state yet. it may take it right after,
+         * false is final until the next publish().
+         */
+        bool has_unread() const
+        {
+            return (middle_.load(std::memory_order_acquire) & kDirty) != 0;
+        }
+
+        ////////////////////////////// consumer side //////////////////////////////
+
+        /**
+         * @brief take the newest published buffer if there is one.
+         *
+         * @return true if read() now refers to a new state
+         */
+        bool update()
+        {
+            if ((middle_.load(std::memory_order_relaxed) & kDirty) == 0)
+            {
+                return false;
+            }
+            const std::uint8_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+            front_ = previous & kIndexMask;
+            return true;
+        }
+
+        /**
+         * @brief the state taken with the last update(). valid until the next update().
+         */
+        const T &read() const
+        {
+            return slots_[front_].value;
+        }
+
+        std::uint64_t get_published_count() const { return published_count_.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr std::uint8_t kIndexMask = 0x3;
+        static constexpr std::uint8_t kDirty = 0x4;
+
+        // * separate cache lines, the producer and the consumer work on different buffers at the same time
+        struct alignas(64) Slot
+        {
+            T value;
+        };
+        std::array<Slot, 3> slots_;
+
+        std::uint8_t back_; // producer only
+        alignas(64) std::atomic<std::uint8_t> middle_;
+        alignas(64) std::uint8_t front_; // consumer only
+
+        std::atomic<std::uint64_t> published_count_;
+    };
+} // namespace kios
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kios
+{
+    /**
+     * @brief fixed set of worker threads for data-parallel loops. the calling thread works along.
+     * parallel_for runs every index once, in chunks taken by whichever thread is free.
+     * ! one parallel_for at a time, calls from several threads are serialized.
+     */
+    class WorkerPool
+    {
+    public:
+        // * worker_count: threads besides the caller, 0 runs everything in the caller
+        explicit WorkerPool(std::size_t worker_count = get_default_worker_count());
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool &) = delete;
+        WorkerPool &operator=(const WorkerPool &) = delete;
+
+        /**
+         * @brief call fn(i) for every i in [0, count) and return when all are done.
+         * all the indices run even if some throw; the exception of the lowest index is rethrown afterwards,
+         * so the reported error does not depend on the scheduling.
+         *
+         * @param count
+         * @param fn must be safe to call concurrently for different indices
+         * @param min_chunk loops with at most this many indices run in the caller only
+         */
+        void parallel_for(std::size_t count, const std::function<void(std::size_t)> &fn, std::size_t min_chunk = 16);
+
+        std::size_t get_worker_count() const { return threads_.size(); }
+
+        static std::size_t get_default_worker_count();
+
+    private:
+        std::vector<std::thread> threads_;
+
+        std::mutex run_mtx_;
+        std::mutex mtx_;
+        std::condition_variable job_cv_;
+        std::condition_variable done_cv_;
+        bool stopThread;
+        std::uint64_t generation_;
+        std::size_t active_count_;
+
+        // * the current job, valid while job_ is set
+        const std::function<void(std::size_t)> *job_;
+        std::size_t job_count_;
+        std::size_t chunk_size_;
+        std::atomic<std::size_t> next_index_;
+
+        std::mutex error_mtx_;
+        std::exception_ptr first_error_;
+        std::size_t first_error_index_;
+
+        void worker_loop();
+        void run_chunks(const std::function<void(std::size_t)> &fn);
+    };
+} // namespace kios
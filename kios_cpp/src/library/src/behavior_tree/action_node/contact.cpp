@@ -33,9 +33,14 @@ namespace Insertion
         // std::cout << str << std::endl;
 
         // std::cerr << "BEFORE CHECK CONTACT SUCCESS" << std::endl;
-        std::cout << "the force: " << get_task_state_ptr()->mios_state.tf_f_ext_k[2] << std::flush;
-
-        if (abs(get_task_state_ptr()->mios_state.tf_f_ext_k[2]) > 7)
+        // * peak of the window since the last task state. it holds every udp sample only with direct_telemetry
+        // * of the messenger, through mios_reader it holds the one sample of each publish.
+        // * fall back to the last sample if the messenger sent no window.
+        const auto &telemetry = get_task_state_ptr()->telemetry;
+        double force_z = telemetry.sample_count > 0 ? telemetry.tf_f_ext_k_max_abs[2] : std::abs(get_task_state_ptr()->mios_state.tf_f_ext_k[2]);
+        std::cout << "the force: " << force_z << std::flush;
+
+        if (force_z > 7)
         {
             // std::cout << "CONTACT SUCCESS" << std::endl;
             mark_success();
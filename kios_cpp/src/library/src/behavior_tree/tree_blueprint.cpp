@@ -0,0 +1,118 @@
+#include "behavior_tree/tree_blueprint.hpp"
+
+#include <functional>
+
+#include <spdlog/spdlog.h>
+
+namespace Insertion
+{
+    TreeBlueprintCache::TreeBlueprintCache(std::size_t capacity)
+        : capacity_(capacity == 0 ? 1 : capacity),
+          hit_count_(0),
+          miss_count_(0)
+    {
+    }
+
+    /**
+     * @brief get the blueprint of the tree xml. the xml is parsed and verified only if it is not in the cache.
+     *
+     * @param factory the factory with all the nodes of the tree registered
+     * @param tree_string
+     * @return std::shared_ptr<TreeBlueprint>
+     * @throw BT::RuntimeError if the xml is invalid
+     */
+    std::shared_ptr<TreeBlueprint> TreeBlueprintCache::get_blueprint(const BT::BehaviorTreeFactory &factory, const std::string &tree_string)
+    {
+        const std::size_t hash = std::hash<std::string>{}(tree_string);
+        auto range = index_.equal_range(hash);
+        for (auto it = range.first; it != range.second; it++)
+        {
+            // * the hash only narrows the search, the text decides
+            if ((*it->second)->tree_string == tree_string)
+            {
+                hit_count_++;
+                lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+                return lru_list_.front();
+            }
+        }
+
+        miss_count_++;
+        auto blueprint = std::make_shared<TreeBlueprint>();
+        blueprint->hash = hash;
+        blueprint->tree_string = tree_string;
+        blueprint->parser = std::make_unique<BT::XMLParser>(factory);
+        // * parse and verify, throws on error before anything is cached
+        blueprint->parser->loadFromText(tree_string);
+
+        lru_list_.push_front(blueprint);
+        index_.emplace(hash, lru_list_.begin());
+        evict();
+        spdlog::debug("tree blueprint cache: compiled tree {:x} ({} cached).", hash, lru_list_.size());
+        return blueprint;
+    }
+
+    /**
+     * @brief instantiate a new tree from the blueprint.
+     *
+     * @param blueprint
+     * @param blackboard the root blackboard of the new tree
+     * @return BT::Tree
+     */
+    BT::Tree TreeBlueprintCache::instantiate(TreeBlueprint &blueprint, BT::Blackboard::Ptr blackboard)
+    {
+        BT::Tree tree = blueprint.parser->instantiateTree(blackboard);
+        if (!blueprint.hasManifest)
+        {
+            record_manifest(blueprint, tree);
+        }
+        tree.manifests = blueprint.manifests;
+        return tree;
+    }
+
+    void TreeBlueprintCache::clear()
+    {
+        index_.clear();
+        lru_list_.clear();
+    }
+
+    /**
+     * @brief record the nodes, their port remapping and the manifests of their types.
+     */
+    void TreeBlueprintCache::record_manifest(TreeBlueprint &blueprint, BT::Tree &tree)
+    {
+        blueprint.nodes.clear();
+        blueprint.manifests.clear();
+        tree.applyVisitor([&blueprint](BT::TreeNode *node)
+                          {
+            const BT::TreeNode &const_node = *node;
+            const BT::NodeConfig &config = const_node.config();
+            blueprint.nodes.push_back({node->registrationName(), node->fullPath(), config.input_ports, config.output_ports});
+            if (config.manifest != nullptr)
+            {
+                blueprint.manifests.emplace(node->registrationName(), *config.manifest);
+            } });
+        blueprint.hasManifest = true;
+    }
+
+    /**
+     * @brief drop the least recently used blueprints above the capacity. the trees built from them are not affected.
+     */
+    void TreeBlueprintCache::evict()
+    {
+        while (lru_list_.size() > capacity_)
+        {
+            auto last = std::prev(lru_list_.end());
+            auto range = index_.equal_range((*last)->hash);
+            for (auto it = range.first; it != range.second; it++)
+            {
+                if (it->second == last)
+                {
+                    index_.erase(it);
+                    break;
+                }
+            }
+            lru_list_.erase(last);
+        }
+    }
+
+} // namespace Insertion
@@ -1,11 +1,65 @@
 #include "behavior_tree/tree_root.hpp"
 
+#include <algorithm>
+#include <unordered_map>
+
 namespace Insertion
 {
+    namespace
+    {
+        /**
+         * @brief an action node is the same in two plans if its type and its ports are the same.
+         * the position in the tree is not part of it, moving or inserting nodes keeps the identity of the others.
+         */
+        std::string get_node_identity(const KiosActionNode &node)
+        {
+            std::vector<std::pair<std::string, std::string>> ports(node.config().input_ports.begin(), node.config().input_ports.end());
+            std::sort(ports.begin(), ports.end());
+            std::string identity = node.registrationName();
+            for (const auto &port : ports)
+            {
+                identity += '\n' + port.first + '=' + port.second;
+            }
+            return identity;
+        }
+
+        /**
+         * @brief initialize the archive of the node, the error names the node. runs in the worker threads,
+         * the warnings are logged afterwards with log_archive_warnings.
+         */
+        void initialize_archive(KiosActionNode &node, std::vector<std::string> &warnings)
+        {
+            try
+            {
+                node.initialize_archive(warnings);
+            }
+            catch (const std::exception &e)
+            {
+                throw BT::RuntimeError("action node ", node.fullPath(), ": ", e.what());
+            }
+        }
+
+        /**
+         * @brief log what initialize_archive collected, in tree order, from the calling thread.
+         */
+        void log_archive_warnings(const std::vector<KiosActionNode *> &nodes, const std::vector<std::vector<std::string>> &warnings)
+        {
+            for (std::size_t i = 0; i < nodes.size(); i++)
+            {
+                for (const auto &warning : warnings[i])
+                {
+                    spdlog::warn(warning);
+                }
+                nodes[i]->test_objects();
+            }
+        }
+    } // namespace
+
     TreeRoot::TreeRoot(std::shared_ptr<kios::TreeState> tree_state_ptr, std::shared_ptr<kios::TaskState> task_state_ptr)
         : tree_state_ptr_(tree_state_ptr),
           task_state_ptr_(task_state_ptr),
-          hasRegisteredNodes(false)
+          hasRegisteredNodes(false),
+          hasArchivedNodes(false)
     {
         set_log();
         // * run tree initialization method
@@ -83,37 +137,8 @@ namespace Insertion
         {
             try
             {
-                // ! the definition of the condition nodes? too many args
-                factory_.registerNodeType<HasObject>("HasObjectApproch", "approach", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<HasObject>("HasObjectContact", "contact", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<AtPosition>("AtPositionApproch", "approach", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<AtPosition>("AtPositionContact", "contact", tree_state_ptr_, task_state_ptr_);
-
-                // * demo action nodes
-                factory_.registerNodeType<Approach>("Approach", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<Contact>("Contact", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<Wiggle>("Wiggle", tree_state_ptr_, task_state_ptr_);
-
-                // * general action nodes
-                factory_.registerNodeType<CartesianMove>("CartesianMove", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<JointMove>("JointMove", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<GripperForce>("GripperForce", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<GripperMove>("GripperMove", tree_state_ptr_, task_state_ptr_);
-
-                // * additional
-                factory_.registerNodeType<ToolLoad>("ToolLoad", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<ToolUnload>("ToolUnload", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<ToolGrasp>("ToolGrasp", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<ToolRelease>("ToolRelease", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<GripperGrasp>("GripperGrasp", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<GripperRelease>("GripperRelease", tree_state_ptr_, task_state_ptr_);
-
-                // * compound
-                factory_.registerNodeType<ToolPick>("ToolPick", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<ToolPlace>("ToolPlace", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<GripperPick>("GripperPick", tree_state_ptr_, task_state_ptr_);
-                factory_.registerNodeType<GripperPlace>("GripperPlace", tree_state_ptr_, task_state_ptr_);
-                // ! BBMOD
+                // * the node types are listed in KiosNodeRegistry
+                KiosNodeRegistry::register_all(factory_, tree_state_ptr_, task_state_ptr_);
             }
             catch (...)
             {
@@ -122,6 +147,8 @@ namespace Insertion
                 return false; // for completeness
             }
             hasRegisteredNodes = true;
+            // * the cached blueprints were verified against the old registrations
+            blueprint_cache_.clear();
         }
         else
         {
@@ -140,19 +167,43 @@ namespace Insertion
     {
         std::vector<kios::NodeArchive> node_archive_list;
 
-        auto archive_visitor = [&node_archive_list, this](BT::TreeNode *node) {
-            if (auto action_node = dynamic_cast<KiosActionNode *>(node))
+        try
+        {
+            const std::vector<KiosActionNode *> &action_nodes = action_nodes_;
+
+            // * a tree from a known blueprint takes over the archives instead of reading all the ports again
+            if (blueprint_ && blueprint_->groundings.has_value() && blueprint_->groundings->size() == action_nodes.size())
+            {
+                const auto &groundings = blueprint_->groundings.value();
+                for (std::size_t i = 0; i < action_nodes.size(); i++)
+                {
+                    action_nodes[i]->get_archive_ref() = groundings[i].archive;
+                    action_nodes[i]->get_object_names_ref() = groundings[i].object_names;
+                    node_archive_list.push_back(groundings[i].archive);
+                }
+                hasArchivedNodes = true;
+                return node_archive_list;
+            }
+
+            // * the nodes read their own ports, the first error in tree order is reported
+            std::vector<std::vector<std::string>> warnings(action_nodes.size());
+            worker_pool_.parallel_for(action_nodes.size(), [&action_nodes, &warnings](std::size_t i)
+                                      { initialize_archive(*action_nodes[i], warnings[i]); });
+            log_archive_warnings(action_nodes, warnings);
+
+            std::vector<NodeGrounding> groundings;
+            groundings.reserve(action_nodes.size());
+            for (auto action_node : action_nodes)
             {
-                action_node->initialize_archive();
                 // ! here just get a copy!
                 auto node_archive = action_node->get_archive_ref();
                 node_archive_list.push_back(node_archive);
+                groundings.push_back({node_archive, action_node->get_obejct_keys_ref(), action_node->get_object_names_ref()});
+            }
+            if (blueprint_)
+            {
+                blueprint_->groundings = std::move(groundings);
             }
-        };
-
-        try
-        {
-            tree_.applyVisitor(archive_visitor);
         }
         catch (const std::exception &e)
         {
@@ -160,9 +211,44 @@ namespace Insertion
             return {};
         }
 
+        hasArchivedNodes = true;
         return node_archive_list;
     }
 
+    /**
+     * @brief the action nodes of the tree, in the order of the visitor. the only walk over the tree with rtti,
+     * done once per construction. later passes use the index.
+     */
+    std::vector<KiosActionNode *> TreeRoot::collect_action_nodes(BT::Tree &tree)
+    {
+        std::vector<KiosActionNode *> action_nodes;
+        tree.applyVisitor([&action_nodes](BT::TreeNode *node) {
+            if (auto action_node = dynamic_cast<KiosActionNode *>(node))
+            {
+                action_nodes.push_back(action_node);
+            }
+        });
+        return action_nodes;
+    }
+
+    /**
+     * @brief collect the archive and the grounded objects of all action nodes. run this after archiving.
+     *
+     * @return std::vector<NodeGrounding>
+     */
+    std::vector<NodeGrounding> TreeRoot::collect_groundings()
+    {
+        std::vector<NodeGrounding> groundings;
+        groundings.reserve(action_nodes_.size());
+        for (auto action_node : action_nodes_)
+        {
+            groundings.push_back({action_node->get_archive_ref(),
+                                  action_node->get_obejct_keys_ref(),
+                                  action_node->get_object_names_ref()});
+        }
+        return groundings;
+    }
+
     /**
      * @brief check: 1. the number of obj keys and obj names consists? 2. the grounded objects are in the DB?
      *  run this after archiving.
@@ -173,64 +259,117 @@ namespace Insertion
     {
         bool flag = true;
 
-        auto object_dict = get_task_state_ptr()->object_dictionary;
-        auto check_visitor = [&flag, &object_dict, this](BT::TreeNode *node) {
-            if (auto action_node = dynamic_cast<KiosActionNode *>(node))
-            {
-                if (flag == true)
+        // * check the nodes in parallel, report in tree order
+        struct GroundingCheck
+        {
+            bool hasKeyMismatch = false;
+            std::vector<std::string> missing_objects;
+        };
+        std::vector<GroundingCheck> checks(action_nodes_.size());
+        const auto &object_dict = get_task_state_ptr()->object_dictionary;
+        try
+        {
+            worker_pool_.parallel_for(action_nodes_.size(), [this, &checks, &object_dict](std::size_t i)
+                                      {
+                auto &objects_ref = action_nodes_[i]->get_object_names_ref();
+                checks[i].hasKeyMismatch = objects_ref.size() != action_nodes_[i]->get_obejct_keys_ref().size();
+                for (auto &item : objects_ref)
                 {
-                    auto &objects_ref = action_node->get_object_names_ref();
-                    auto &arch = action_node->get_archive_ref();
-                    auto &keys_ref = action_node->get_obejct_keys_ref();
-
-                    if (objects_ref.size() != keys_ref.size())
+                    if (object_dict.find(item) == object_dict.end()) // ! if this object doesn't exist
                     {
-                        spdlog::critical("OH NO: The number of object keys and object names doesn't consist in the action node with group: " + std::to_string(arch.action_group) + ", id: " + std::to_string(arch.action_id) + "!");
-                        // spdlog::debug("The following are the keys and the names:");
-                        spdlog::debug("KEYS: ");
-                        for (auto &k : keys_ref)
-                        {
-                            spdlog::debug(k);
-                        }
-                        spdlog::debug("NAMES: ");
-                        for (auto &n : objects_ref)
-                        {
-                            spdlog::debug(n);
-                        }
-                        flag = false; // but still do the existence check
+                        checks[i].missing_objects.push_back(item);
                     }
+                } });
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << '\n';
+            return false;
+        }
 
-                    for (auto &item : objects_ref)
-                    {
-                        if (object_dict.find(item) == object_dict.end()) // ! if this object doesn't exist
-                        {
-                            spdlog::critical("OH NO: the object \'" + item + "\' doesn't exist in the object dictionary fetched from mongo DB!");
-                            flag = false;
-                        }
-                    }
+        for (std::size_t i = 0; i < action_nodes_.size(); i++)
+        {
+            auto action_node = action_nodes_[i];
+            if (checks[i].hasKeyMismatch)
+            {
+                auto &arch = action_node->get_archive_ref();
+                spdlog::critical("OH NO: The number of object keys and object names doesn't consist in the action node with group: " + std::to_string(arch.action_group) + ", id: " + std::to_string(arch.action_id) + "!");
+                // spdlog::debug("The following are the keys and the names:");
+                spdlog::debug("KEYS: ");
+                for (auto &k : action_node->get_obejct_keys_ref())
+                {
+                    spdlog::debug(k);
                 }
-                else
+                spdlog::debug("NAMES: ");
+                for (auto &n : action_node->get_object_names_ref())
                 {
-                    // error has been triggered. skip...
+                    spdlog::debug(n);
                 }
+                flag = false; // but still do the existence check
             }
-        };
 
-        try
+            for (auto &item : checks[i].missing_objects)
+            {
+                spdlog::critical("OH NO: the object \'" + item + "\' doesn't exist in the object dictionary fetched from mongo DB!");
+                flag = false;
+            }
+
+            if (flag == false)
+            {
+                // error has been triggered. skip the rest...
+                break;
+            }
+        }
+
+        return flag;
+    }
+
+    /**
+     * @brief numbers of the current tree, without walking it.
+     *
+     * @return TreeStatistics
+     */
+    TreeStatistics TreeRoot::get_tree_statistics() const
+    {
+        TreeStatistics statistics;
+        if (blueprint_)
         {
-            tree_.applyVisitor(check_visitor);
+            statistics.node_count = blueprint_->nodes.size();
+            for (const auto &node : blueprint_->nodes)
+            {
+                if (auto type_id = KiosNodeRegistry::get_type_id(node.registration_id))
+                {
+                    statistics.type_counts[type_id.value()]++;
+                }
+            }
         }
-        catch (const std::exception &e)
+        statistics.action_node_count = action_nodes_.size();
+        for (auto action_node : action_nodes_)
         {
-            std::cerr << e.what() << '\n';
-            return false;
+            if (action_node->has_succeeded_once())
+            {
+                statistics.succeeded_count++;
+            }
         }
+        return statistics;
+    }
 
-        return flag;
+    /**
+     * @brief halt the tree and clear the succeeded-once latches, the tree runs again from the start.
+     * the archives are kept.
+     */
+    void TreeRoot::reset_tree()
+    {
+        tree_.haltTree();
+        for (auto action_node : action_nodes_)
+        {
+            action_node->reset_success();
+        }
     }
 
     /**
      * @brief Den Wald aufbauen mit dem gegebenen String.
+     * the xml is parsed only the first time, later the tree is instantiated from the cached blueprint.
      *
      * @param tree_string
      * @return true
@@ -240,7 +379,11 @@ namespace Insertion
     {
         try
         {
-            tree_ = factory_.createTreeFromText(tree_string);
+            auto blueprint = blueprint_cache_.get_blueprint(factory_, tree_string);
+            tree_ = blueprint_cache_.instantiate(*blueprint);
+            blueprint_ = blueprint;
+            action_nodes_ = collect_action_nodes(tree_);
+            hasArchivedNodes = false;
         }
         catch (...)
         {
@@ -251,6 +394,112 @@ namespace Insertion
         return true;
     }
 
+    /**
+     * @brief replace the running tree with a new plan, keeping the state of the action nodes that did not change.
+     * an action node of the new tree that has the same type and the same ports as one of the old tree
+     * takes over its archive, its objects and its succeeded-once latch. only the new or changed action nodes
+     * are archived. the old tree is halted. if the new plan is invalid, the old tree stays untouched.
+     *
+     * @param tree_string
+     * @return std::optional<TreeUpdate> std::nullopt if the new tree cannot be constructed or archived
+     */
+    std::optional<TreeUpdate> TreeRoot::update_tree(const std::string &tree_string)
+    {
+        std::shared_ptr<TreeBlueprint> blueprint;
+        BT::Tree new_tree;
+        TreeUpdate update;
+        std::vector<KiosActionNode *> new_nodes;
+        std::vector<NodeGrounding> groundings;
+        try
+        {
+            blueprint = blueprint_cache_.get_blueprint(factory_, tree_string);
+            new_tree = blueprint_cache_.instantiate(*blueprint);
+
+            // * the action nodes of the old tree by identity. equal nodes are matched in tree order.
+            std::unordered_multimap<std::string, KiosActionNode *> old_nodes;
+            for (auto action_node : action_nodes_)
+            {
+                old_nodes.emplace(get_node_identity(*action_node), action_node);
+            }
+
+            new_nodes = collect_action_nodes(new_tree);
+            const bool hasCachedGroundings = blueprint->groundings.has_value() && blueprint->groundings->size() == new_nodes.size();
+            std::vector<KiosActionNode *> uninitialized_nodes;
+            groundings.reserve(new_nodes.size());
+            for (std::size_t i = 0; i < new_nodes.size(); i++)
+            {
+                KiosActionNode *new_node = new_nodes[i];
+                auto old_it = old_nodes.end();
+                auto range = old_nodes.equal_range(get_node_identity(*new_node));
+                if (range.first != range.second)
+                {
+                    // * the first one in tree order
+                    old_it = std::min_element(range.first, range.second, [&](const auto &a, const auto &b)
+                                              { return a.second->UID() < b.second->UID(); });
+                }
+
+                if (old_it != old_nodes.end() && hasArchivedNodes)
+                {
+                    KiosActionNode *old_node = old_it->second;
+                    new_node->get_archive_ref() = old_node->get_archive_ref();
+                    new_node->get_object_names_ref() = old_node->get_object_names_ref();
+                    update.kept_count++;
+                }
+                else if (hasCachedGroundings)
+                {
+                    new_node->get_archive_ref() = blueprint->groundings.value()[i].archive;
+                    new_node->get_object_names_ref() = blueprint->groundings.value()[i].object_names;
+                    update.changed_archives.push_back(new_node->get_archive_ref());
+                }
+                else
+                {
+                    // * archived below, in parallel
+                    uninitialized_nodes.push_back(new_node);
+                }
+
+                if (old_it != old_nodes.end())
+                {
+                    if (old_it->second->has_succeeded_once())
+                    {
+                        new_node->mark_success();
+                    }
+                    old_nodes.erase(old_it);
+                }
+            }
+            std::vector<std::vector<std::string>> warnings(uninitialized_nodes.size());
+            worker_pool_.parallel_for(uninitialized_nodes.size(), [&uninitialized_nodes, &warnings](std::size_t i)
+                                      { initialize_archive(*uninitialized_nodes[i], warnings[i]); });
+            log_archive_warnings(uninitialized_nodes, warnings);
+            for (auto new_node : uninitialized_nodes)
+            {
+                update.changed_archives.push_back(new_node->get_archive_ref());
+            }
+            for (auto new_node : new_nodes)
+            {
+                groundings.push_back({new_node->get_archive_ref(), new_node->get_obejct_keys_ref(), new_node->get_object_names_ref()});
+            }
+            update.removed_count = old_nodes.size();
+        }
+        catch (const std::exception &e)
+        {
+            spdlog::error("update_tree: the new tree is rejected: {}", e.what());
+            return std::nullopt;
+        }
+
+        if (!blueprint->groundings.has_value())
+        {
+            blueprint->groundings = std::move(groundings);
+        }
+        tree_.haltTree();
+        tree_ = std::move(new_tree);
+        action_nodes_ = std::move(new_nodes);
+        blueprint_ = blueprint;
+        hasArchivedNodes = true;
+        spdlog::info("update_tree: {} action nodes kept, {} new or changed, {} removed.",
+                     update.kept_count, update.changed_archives.size(), update.removed_count);
+        return update;
+    }
+
     std::shared_ptr<kios::TreeState> TreeRoot::get_tree_state_ptr()
     {
         return tree_state_ptr_;
@@ -259,6 +508,14 @@ namespace Insertion
     {
         return task_state_ptr_;
     }
+    std::shared_ptr<const TreeBlueprint> TreeRoot::get_blueprint() const
+    {
+        return blueprint_;
+    }
+    const TreeBlueprintCache &TreeRoot::get_blueprint_cache() const
+    {
+        return blueprint_cache_;
+    }
 
     /**
      * @brief only tick once, return running immediately if a node is running
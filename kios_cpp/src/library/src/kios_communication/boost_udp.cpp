@@ -1,28 +1,175 @@
 #include "kios_communication/boost_udp.hpp"
 
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#endif
+
 namespace kios
 {
     // BTReceiver Implementation
-    void BTReceiver::receive_message()
+    /**
+     * @brief post an async receive directly into the next free slot of the ring.
+     * the slots are the buffer pool, nothing is allocated per datagram.
+     */
+    void BTReceiver::start_receive()
     {
-        while (!stopThread.load())
+        if (stopThread.load())
+        {
+            return;
+        }
+        MessageRing::Slot *slot = messageRing.acquire_write_slot();
+        if (slot == nullptr)
         {
-            char buffer[1024];
-            size_t length = socket_.receive_from(boost::asio::buffer(buffer), sender_endpoint_);
-            buffer[length] = '\0';
+            socket_.async_receive_from(
+                boost::asio::buffer(overflowBuffer_, kMessageSlotSize - 1), sender_endpoint_,
+                [this](const boost::system::error_code &error, std::size_t length)
+                { handle_receive(error, length, nullptr); });
+            return;
+        }
+        socket_.async_receive_from(
+            boost::asio::buffer(slot->data, kMessageSlotSize - 1), sender_endpoint_,
+            [this, slot](const boost::system::error_code &error, std::size_t length)
+            { handle_receive(error, length, slot); });
+    }
+
+    void BTReceiver::handle_receive(const boost::system::error_code &error, std::size_t length, MessageRing::Slot *slot)
+    {
+        if (error == boost::asio::error::operation_aborted || stopThread.load())
+        {
+            return;
+        }
+        if (error)
+        {
+            std::cerr << "BTReceiver: receive error: " << error.message() << std::endl;
+            start_receive();
+            return;
+        }
+        if (slot == nullptr)
+        {
+            // * the consumer may have freed slots while the receive was pending
+            slot = messageRing.acquire_write_slot();
+            if (slot != nullptr)
+            {
+                std::memcpy(slot->data, overflowBuffer_, length);
+            }
+        }
+        if (slot == nullptr)
+        {
+            messageRing.record_overflow();
+        }
+        else
+        {
+            slot->data[length] = '\0';
+            slot->length = length;
+            messageRing.commit_write();
+        }
+        // * more phase messages may already be queued in the socket, take them in one go
+        while (receive_batch() == kReceiveBatchSize)
+        {
+        }
+        notify_consumer();
+        start_receive();
+    }
+
+    /**
+     * @brief non-blocking read of the already queued datagrams into the free slots.
+     * on linux this is a single recvmmsg call for up to kReceiveBatchSize datagrams.
+     *
+     * @return number of datagrams read
+     */
+    std::size_t BTReceiver::receive_batch()
+    {
+#ifdef __linux__
+        mmsghdr msgs[kReceiveBatchSize];
+        iovec iovecs[kReceiveBatchSize];
+        std::size_t freeSlots = 0;
+        for (; freeSlots < kReceiveBatchSize; freeSlots++)
+        {
+            MessageRing::Slot *slot = messageRing.acquire_write_slot(freeSlots);
+            if (slot == nullptr)
+            {
+                break;
+            }
+            iovecs[freeSlots].iov_base = slot->data;
+            iovecs[freeSlots].iov_len = kMessageSlotSize - 1;
+            std::memset(&msgs[freeSlots], 0, sizeof(mmsghdr));
+            msgs[freeSlots].msg_hdr.msg_iov = &iovecs[freeSlots];
+            msgs[freeSlots].msg_hdr.msg_iovlen = 1;
+        }
+        if (freeSlots == 0)
+        {
+            // * ring full. leave the datagrams in the socket, start_receive drops them one by one.
+            return 0;
+        }
+        int received = ::recvmmsg(socket_.native_handle(), msgs, static_cast<unsigned int>(freeSlots), MSG_DONTWAIT, nullptr);
+        if (received <= 0)
+        {
+            return 0;
+        }
+        for (int i = 0; i < received; i++)
+        {
+            MessageRing::Slot *slot = messageRing.acquire_write_slot(static_cast<std::size_t>(i));
+            slot->length = msgs[i].msg_len;
+            slot->data[slot->length] = '\0';
+        }
+        messageRing.commit_write(static_cast<std::size_t>(received));
+        return static_cast<std::size_t>(received);
+#else
+        std::size_t received = 0;
+        boost::system::error_code error;
+        while (received < kReceiveBatchSize && socket_.available(error) > 0 && !error)
+        {
+            MessageRing::Slot *slot = messageRing.acquire_write_slot();
+            if (slot == nullptr)
+            {
+                break;
+            }
+            std::size_t length = socket_.receive_from(boost::asio::buffer(slot->data, kMessageSlotSize - 1), sender_endpoint_, 0, error);
+            if (error)
+            {
+                break;
+            }
+            slot->data[length] = '\0';
+            slot->length = length;
+            messageRing.commit_write();
+            received++;
+        }
+        return received;
+#endif
+    }
+
+    void BTReceiver::notify_consumer()
+    {
+        // * pairs with the fence in wait_for_message: either the waiter sees the committed message
+        // * or this thread sees the waiter, the store-load pair must not be reordered
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (hasWaiter.load())
+        {
+            // * lock so the notification cannot fall between the predicate check and the wait
             {
                 std::lock_guard<std::mutex> lock(mtx);
-                messageQueue.push(buffer);
             }
             cv.notify_one();
         }
+        // * wake up the consumer (e.g. the tree tick) if it is registered
+        std::lock_guard<std::mutex> lock(callback_mtx);
+        if (message_callback_)
+        {
+            message_callback_();
+        }
     }
 
-    BTReceiver::BTReceiver(std::string ip, int port, bool isThreading)
+    BTReceiver::BTReceiver(std::string ip, int port, bool isThreading, RingOverflowPolicy policy)
         : socket_(io_context_, boost::asio::ip::udp::endpoint(boost::asio::ip::address::from_string(ip), port)),
-          stopThread(false)
+          stopThread(false),
+          messageRing(policy),
+          hasWaiter(false)
     {
-        receiverThread = std::thread(&BTReceiver::receive_message, this);
+        start_receive();
+        receiverThread = std::thread([this]()
+                                     { io_context_.run(); });
     }
 
     BTReceiver::~BTReceiver()
@@ -30,60 +177,96 @@ namespace kios
         stop_thread();
         if (receiverThread.joinable())
             receiverThread.join();
+        boost::system::error_code error;
+        socket_.close(error);
     }
 
+    /**
+     * @brief get the next message without blocking. with RingOverflowPolicy::LATEST_WINS this is the newest one.
+     * ! must only be called from one consumer thread.
+     *
+     * @param message reused, no reallocation as long as its capacity is large enough
+     * @return true if a message was read
+     */
     bool BTReceiver::get_message(std::string &message)
     {
-        std::unique_lock<std::mutex> lock(mtx);
-        if (!messageQueue.empty())
-        {
-            message = messageQueue.front();
-            messageQueue.pop();
-            return true;
-        }
-        return false;
+        return messageRing.pop(message);
     }
 
+    /**
+     * @brief block until a message is available and read it.
+     * ! must only be called from one consumer thread.
+     *
+     * @param message
+     */
     void BTReceiver::wait_for_message(std::string &message)
     {
+        if (messageRing.pop(message))
+        {
+            return;
+        }
         std::unique_lock<std::mutex> lock(mtx);
-        cv.wait(lock, [this] { return !messageQueue.empty(); });
-        message = messageQueue.front();
-        messageQueue.pop();
+        hasWaiter.store(true);
+        // * the ring is checked again only after the waiter flag is visible to the producer
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        while (!messageRing.pop(message))
+        {
+            cv.wait(lock, [this] { return !messageRing.empty(); });
+        }
+        hasWaiter.store(false);
     }
 
-    void BTReceiver::stop_thread()
+    /**
+     * @brief register a callback invoked in the receiver thread after each new message is queued.
+     * keep it short, it blocks the receive loop.
+     *
+     * @param callback
+     */
+    void BTReceiver::set_message_callback(std::function<void()> callback)
     {
-        stopThread.store(true);
+        std::lock_guard<std::mutex> lock(callback_mtx);
+        message_callback_ = std::move(callback);
     }
 
-    // BTSender Implementation
-    void BTSender::send_message()
+    /**
+     * @brief stop the receiver. the run loop returns at once, no need to wait for another datagram.
+     * the pending receive is abandoned, the socket is closed in the destructor.
+     */
+    void BTReceiver::stop_thread()
     {
-        while (!stopThread.load())
+        if (stopThread.exchange(true))
         {
-            std::lock_guard<std::mutex> lock(mtx);
-            if (!messageQueue.empty())
-            {
-                std::string msg = messageQueue.front();
-                socket_.send_to(boost::asio::buffer(msg), target_endpoint_);
-                messageQueue.pop();
-            }
+            return;
         }
+        io_context_.stop();
     }
 
+    // BTSender Implementation
     BTSender::BTSender(std::string ip, int port, bool isThreading)
-        : socket_(io_context_, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0)),
+        : work_guard_(boost::asio::make_work_guard(io_context_)),
+          socket_(io_context_, boost::asio::ip::udp::endpoint(boost::asio::ip::udp::v4(), 0)),
           target_endpoint_(boost::asio::ip::address::from_string(ip), port),
-          stopThread(false)
+          rate_timer_(io_context_),
+          stopThread(false),
+          isFlushScheduled(false),
+          isWaitingForRate_(false),
+          rate_limit_(0.0),
+          rate_tokens_(0.0),
+          rate_last_refill_(std::chrono::steady_clock::now()),
+          batchCount(0)
     {
+        sendingBatch_.reserve(kSendBatchSize);
     }
 
+    /**
+     * @brief start the sender thread. it sleeps in the io_context until a message is pushed.
+     */
     bool BTSender::start()
     {
         try
         {
-            senderThread = std::thread(&BTSender::send_message, this);
+            senderThread = std::thread([this]()
+                                       { io_context_.run(); });
         }
         catch (...)
         {
@@ -103,16 +286,194 @@ namespace kios
         stop_thread();
         if (senderThread.joinable())
             senderThread.join();
+        boost::system::error_code error;
+        socket_.close(error);
     }
 
     void BTSender::push_message(std::string &&message)
     {
-        std::unique_lock<std::mutex> lock(mtx);
-        messageQueue.push(message);
+        push_message(std::move(message), target_endpoint_);
+    }
+
+    /**
+     * @brief queue a message for the given endpoint. the string is moved through to the socket without copy.
+     * messages pushed before the sender thread wakes up are sent together in one batch.
+     */
+    void BTSender::push_message(std::string &&message, const boost::asio::ip::udp::endpoint &endpoint)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            messageQueue.push_back(OutgoingMessage{std::move(message), endpoint});
+            if (isFlushScheduled)
+            {
+                return;
+            }
+            isFlushScheduled = true;
+        }
+        schedule_flush();
+    }
+
+    void BTSender::schedule_flush()
+    {
+        boost::asio::post(io_context_, [this]()
+                          { flush(); });
+    }
+
+    /**
+     * @brief sender thread. take the queued messages batch by batch and send them.
+     */
+    void BTSender::flush()
+    {
+        if (stopThread.load() || isWaitingForRate_)
+        {
+            return;
+        }
+        while (true)
+        {
+            if (sendingBatch_.empty())
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                while (!messageQueue.empty() && sendingBatch_.size() < kSendBatchSize)
+                {
+                    sendingBatch_.push_back(std::move(messageQueue.front()));
+                    messageQueue.pop_front();
+                }
+                if (sendingBatch_.empty())
+                {
+                    isFlushScheduled = false;
+                    return;
+                }
+            }
+
+            std::size_t allowed = take_rate_tokens(sendingBatch_.size());
+            if (allowed == 0)
+            {
+                // * rate cap reached. sleep until the next token and go on.
+                isWaitingForRate_ = true;
+                rate_timer_.expires_after(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>((1.0 - rate_tokens_) / rate_limit_)));
+                rate_timer_.async_wait([this](const boost::system::error_code &error)
+                                       {
+                                           isWaitingForRate_ = false;
+                                           if (!error)
+                                           {
+                                               flush();
+                                           } });
+                return;
+            }
+
+            std::size_t sent = send_batch(allowed);
+            sendingBatch_.erase(sendingBatch_.begin(), sendingBatch_.begin() + sent);
+        }
+    }
+
+    /**
+     * @brief token bucket with a burst of one batch.
+     *
+     * @return how many of the requested messages may be sent now
+     */
+    std::size_t BTSender::take_rate_tokens(std::size_t requested)
+    {
+        if (rate_limit_ <= 0.0)
+        {
+            return requested;
+        }
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - rate_last_refill_).count();
+        rate_last_refill_ = now;
+        rate_tokens_ = std::min(static_cast<double>(kSendBatchSize), rate_tokens_ + elapsed * rate_limit_);
+        std::size_t allowed = std::min(requested, static_cast<std::size_t>(rate_tokens_));
+        rate_tokens_ -= static_cast<double>(allowed);
+        return allowed;
+    }
+
+    /**
+     * @brief send the first count messages of the batch. on linux this is one sendmmsg call.
+     * failed messages are counted and dropped, udp gives no delivery guarantee anyway.
+     *
+     * @return number of messages handled (sent or dropped)
+     */
+    std::size_t BTSender::send_batch(std::size_t count)
+    {
+        std::size_t handled = 0;
+        batchCount++;
+#ifdef __linux__
+        mmsghdr msgs[kSendBatchSize];
+        iovec iovecs[kSendBatchSize];
+        for (std::size_t i = 0; i < count; i++)
+        {
+            OutgoingMessage &message = sendingBatch_[i];
+            iovecs[i].iov_base = const_cast<char *>(message.payload.data());
+            iovecs[i].iov_len = message.payload.size();
+            std::memset(&msgs[i], 0, sizeof(mmsghdr));
+            msgs[i].msg_hdr.msg_name = message.endpoint.data();
+            msgs[i].msg_hdr.msg_namelen = static_cast<socklen_t>(message.endpoint.size());
+            msgs[i].msg_hdr.msg_iov = &iovecs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = ::sendmmsg(socket_.native_handle(), msgs, static_cast<unsigned int>(count), 0);
+
+        std::lock_guard<std::mutex> lock(statistics_mtx);
+        if (sent <= 0)
+        {
+            // * the first message failed. drop it and retry the rest in the next round.
+            statistics_[sendingBatch_[0].endpoint].send_errors++;
+            return 1;
+        }
+        for (int i = 0; i < sent; i++)
+        {
+            SendStatistics &stats = statistics_[sendingBatch_[i].endpoint];
+            stats.messages_sent++;
+            stats.bytes_sent += msgs[i].msg_len;
+        }
+        handled = static_cast<std::size_t>(sent);
+#else
+        std::lock_guard<std::mutex> lock(statistics_mtx);
+        for (; handled < count; handled++)
+        {
+            OutgoingMessage &message = sendingBatch_[handled];
+            SendStatistics &stats = statistics_[message.endpoint];
+            boost::system::error_code error;
+            std::size_t bytes = socket_.send_to(boost::asio::buffer(message.payload), message.endpoint, 0, error);
+            if (error)
+            {
+                stats.send_errors++;
+                continue;
+            }
+            stats.messages_sent++;
+            stats.bytes_sent += bytes;
+        }
+#endif
+        return handled;
+    }
+
+    /**
+     * @brief cap the send rate. messages over the cap stay queued, they are not dropped.
+     *
+     * @param messages_per_second 0 or less means no limit
+     */
+    void BTSender::set_rate_limit(double messages_per_second)
+    {
+        boost::asio::post(io_context_, [this, messages_per_second]()
+                          {
+                              rate_limit_ = messages_per_second;
+                              rate_tokens_ = std::min(1.0, messages_per_second);
+                              rate_last_refill_ = std::chrono::steady_clock::now(); });
+    }
+
+    std::map<boost::asio::ip::udp::endpoint, SendStatistics> BTSender::get_statistics()
+    {
+        std::lock_guard<std::mutex> lock(statistics_mtx);
+        return statistics_;
     }
 
     void BTSender::stop_thread()
     {
-        stopThread.store(true);
+        if (stopThread.exchange(true))
+        {
+            return;
+        }
+        work_guard_.reset();
+        io_context_.stop();
     }
 } // namespace kios
@@ -0,0 +1,182 @@
+#include "kios_communication/telemetry_decoder.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace kios
+{
+    namespace
+    {
+        const char *skip_space(const char *it, const char *end)
+        {
+            while (it < end && (*it == ' ' || *it == '\t' || *it == '\n' || *it == '\r'))
+            {
+                it++;
+            }
+            return it;
+        }
+
+        bool key_equals(const char *key, std::size_t key_length, const char *name)
+        {
+            return std::strlen(name) == key_length && std::memcmp(key, name, key_length) == 0;
+        }
+
+        /**
+         * @brief parse a json number array of exactly N elements.
+         *
+         * @return position after the array, nullptr if the value is not such an array
+         */
+        template <std::size_t N>
+        const char *parse_array(const char *it, const char *end, std::array<double, N> &values)
+        {
+            if (it >= end || *it != '[')
+            {
+                return nullptr;
+            }
+            it++;
+            std::size_t count = 0;
+            while (true)
+            {
+                it = skip_space(it, end);
+                if (it >= end)
+                {
+                    return nullptr;
+                }
+                if (*it == ']')
+                {
+                    return count == N ? it + 1 : nullptr;
+                }
+                if (count == N)
+                {
+                    return nullptr;
+                }
+                char *number_end = nullptr;
+                values[count] = std::strtod(it, &number_end);
+                if (number_end == it || number_end > end)
+                {
+                    return nullptr;
+                }
+                count++;
+                it = skip_space(number_end, end);
+                if (it < end && *it == ',')
+                {
+                    it++;
+                }
+            }
+        }
+
+        const char *parse_number(const char *it, const char *end, double &value)
+        {
+            char *number_end = nullptr;
+            value = std::strtod(it, &number_end);
+            if (number_end == it || number_end > end)
+            {
+                return nullptr;
+            }
+            return number_end;
+        }
+    } // namespace
+
+    bool decode_mios_telemetry(const char *data, std::size_t length, MiosTelemetry &telemetry)
+    {
+        const char *it = data;
+        const char *end = data + length;
+        bool isDecoded = false;
+        telemetry.field_mask = 0;
+        while (it < end)
+        {
+            // * next string token
+            it = static_cast<const char *>(std::memchr(it, '"', end - it));
+            if (it == nullptr)
+            {
+                break;
+            }
+            const char *key = ++it;
+            while (it < end && *it != '"')
+            {
+                // skip escaped characters
+                it += (*it == '\\') ? 2 : 1;
+            }
+            if (it >= end)
+            {
+                break;
+            }
+            const std::size_t key_length = it - key;
+            it = skip_space(it + 1, end);
+            // * a string value, not a key
+            if (it >= end || *it != ':')
+            {
+                continue;
+            }
+            it = skip_space(it + 1, end);
+
+            const char *value_end = nullptr;
+            TelemetryField field;
+            if (key_equals(key, key_length, "TF_F_ext_K"))
+            {
+                std::array<double, 6> values;
+                value_end = parse_array(it, end, values);
+                if (value_end != nullptr)
+                {
+                    telemetry.tf_f_ext_k = values;
+                }
+                field = TELEMETRY_TF_F_EXT_K;
+            }
+            else if (key_equals(key, key_length, "T_T_EE"))
+            {
+                std::array<double, 16> values;
+                value_end = parse_array(it, end, values);
+                if (value_end != nullptr)
+                {
+                    telemetry.t_t_ee = values;
+                }
+                field = TELEMETRY_T_T_EE;
+            }
+            else if (key_equals(key, key_length, "tau_ext"))
+            {
+                std::array<double, 7> values;
+                value_end = parse_array(it, end, values);
+                if (value_end != nullptr)
+                {
+                    telemetry.tau_ext = values;
+                }
+                field = TELEMETRY_TAU_EXT;
+            }
+            else if (key_equals(key, key_length, "q"))
+            {
+                std::array<double, 7> values;
+                value_end = parse_array(it, end, values);
+                if (value_end != nullptr)
+                {
+                    telemetry.q = values;
+                }
+                field = TELEMETRY_Q;
+            }
+            else if (key_equals(key, key_length, "system_time"))
+            {
+                double value = 0;
+                value_end = parse_number(it, end, value);
+                if (value_end != nullptr)
+                {
+                    telemetry.system_time = value;
+                }
+                field = TELEMETRY_SYSTEM_TIME;
+            }
+            else
+            {
+                // * unknown key. continue scanning inside its value.
+                continue;
+            }
+
+            if (value_end == nullptr)
+            {
+                // * known key with an unexpected value, leave the field as it is
+                continue;
+            }
+            telemetry.field_mask |= field;
+            isDecoded = true;
+            it = value_end;
+        }
+        return isDecoded;
+    }
+} // namespace kios
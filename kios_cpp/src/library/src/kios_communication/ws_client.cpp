@@ -1,6 +1,36 @@
 #include "kios_communication/ws_client.hpp"
 /***************** asynchronized response ***************/
 
+/**
+ * @brief the inbound channel of the responses to a mios method.
+ */
+MiosChannel get_mios_channel(const std::string &method)
+{
+    if (method == "start_and_monitor" || method == "wait_for_task")
+    {
+        return MiosChannel::TASK_RESULT;
+    }
+    if (method == "subscribe_telemetry" || method == "unsubscribe_telemetry")
+    {
+        return MiosChannel::TELEMETRY_ACK;
+    }
+    return MiosChannel::COMMAND_ACK;
+}
+
+const char *get_mios_channel_name(MiosChannel channel)
+{
+    switch (channel)
+    {
+    case MiosChannel::TASK_RESULT:
+        return "task result";
+    case MiosChannel::COMMAND_ACK:
+        return "command ack";
+    case MiosChannel::TELEMETRY_ACK:
+        return "telemetry ack";
+    }
+    return "unknown";
+}
+
 /******************* connection_metadata ****************/
 // Getter for connection handle
 websocketpp::connection_hdl connection_metadata::get_hdl() const
@@ -112,15 +142,17 @@ int websocket_endpoint::connect(std::string const &uri)
         &m_endpoint,
         websocketpp::lib::placeholders::_1));
     con->set_fail_handler(websocketpp::lib::bind(
-        &connection_metadata::on_fail,
+        &websocket_endpoint::on_connection_lost,
+        this,
         metadata_ptr,
-        &m_endpoint,
-        websocketpp::lib::placeholders::_1));
+        websocketpp::lib::placeholders::_1,
+        true));
     con->set_close_handler(websocketpp::lib::bind(
-        &connection_metadata::on_close,
+        &websocket_endpoint::on_connection_lost,
+        this,
         metadata_ptr,
-        &m_endpoint,
-        websocketpp::lib::placeholders::_1));
+        websocketpp::lib::placeholders::_1,
+        false));
     // * set message handler for the connection *(here default method)
     con->set_message_handler(websocketpp::lib::bind(
         &connection_metadata::on_message,
@@ -161,15 +193,17 @@ int websocket_endpoint::special_connect(std::string const &uri)
         &m_endpoint,
         websocketpp::lib::placeholders::_1));
     con->set_fail_handler(websocketpp::lib::bind(
-        &connection_metadata::on_fail,
+        &websocket_endpoint::on_connection_lost,
+        this,
         metadata_ptr,
-        &m_endpoint,
-        websocketpp::lib::placeholders::_1));
+        websocketpp::lib::placeholders::_1,
+        true));
     con->set_close_handler(websocketpp::lib::bind(
-        &connection_metadata::on_close,
+        &websocket_endpoint::on_connection_lost,
+        this,
         metadata_ptr,
-        &m_endpoint,
-        websocketpp::lib::placeholders::_1));
+        websocketpp::lib::placeholders::_1,
+        false));
     // * set message handler for the connection *(here default method)
     con->set_message_handler(websocketpp::lib::bind(
         &websocket_endpoint::message_handler_callback,
@@ -183,13 +217,292 @@ int websocket_endpoint::special_connect(std::string const &uri)
     return new_id;
 }
 
+/**
+ * @brief demultiplex the incoming messages to the pending calls.
+ * a response with "request_id" goes to its call, a late response to a cancelled call is dropped: nobody waits for it.
+ * a response without id (mios that does not echo the id) can't be matched: it is taken as the late response of
+ * the oldest cancelled call if there is one, else it goes to the call only if exactly one is pending.
+ * ! without id, calls in flight at the same time can't be told apart: their responses are not given to any call.
+ * unparsable, unattributable and unsolicited messages go to the command ack channel.
+ *
+ * @param hdl
+ * @param msg
+ */
 void websocket_endpoint::message_handler_callback(websocketpp::connection_hdl hdl, client::message_ptr msg)
 {
-    message_queue_.push(msg->get_payload());
-    spdlog::info("message_handler: message received!");
+    std::optional<nlohmann::json> response;
+    try
+    {
+        response = nlohmann::json::parse(msg->get_payload());
+    }
+    catch (nlohmann::json::parse_error &e)
+    {
+        spdlog::error("message_handler: JSON parsing failed: {}", e.what());
+    }
+
+    if (!response.has_value())
+    {
+        // * no call is completed with a frame that can't be read, the waiter times out instead
+        push_inbound(MiosChannel::COMMAND_ACK, msg->get_payload());
+        return;
+    }
+
+    PendingCall call;
+    {
+        std::unique_lock<std::mutex> lock(pending_mtx_);
+        auto call_it = pending_calls_.end();
+        if (response->is_object() && response->contains("request_id"))
+        {
+            const auto &id = response->at("request_id");
+            if (id.is_number_unsigned())
+            {
+                call_it = pending_calls_.find(id.get<std::uint64_t>());
+            }
+            if (call_it == pending_calls_.end())
+            {
+                if (id.is_number_unsigned())
+                {
+                    auto cancelled_it = cancelled_calls_.find(id.get<std::uint64_t>());
+                    if (cancelled_it != cancelled_calls_.end())
+                    {
+                        const MiosChannel channel = cancelled_it->second;
+                        cancelled_calls_.erase(cancelled_it);
+                        lock.unlock();
+                        spdlog::debug("message_handler: late {} for cancelled request {}, dropped.", get_mios_channel_name(channel), id.dump());
+                        return;
+                    }
+                }
+                lock.unlock();
+                spdlog::warn("message_handler: response to unknown request {}, pushed to the command ack channel.", id.dump());
+                push_inbound(MiosChannel::COMMAND_ACK, msg->get_payload());
+                return;
+            }
+        }
+        else if (!cancelled_calls_.empty())
+        {
+            // * the late response of a timed out or cancelled call must not complete the next call
+            auto cancelled_it = cancelled_calls_.begin();
+            const std::uint64_t request_id = cancelled_it->first;
+            cancelled_calls_.erase(cancelled_it);
+            lock.unlock();
+            spdlog::debug("message_handler: response without id taken as the late response of cancelled request {}, dropped.", request_id);
+            return;
+        }
+        else if (pending_calls_.size() == 1)
+        {
+            call_it = pending_calls_.begin();
+        }
+        else if (pending_calls_.size() > 1)
+        {
+            const std::size_t pending_count = pending_calls_.size();
+            lock.unlock();
+            spdlog::warn("message_handler: response without id and {} pending calls, can't be attributed. pushed to the command ack channel.", pending_count);
+            push_inbound(MiosChannel::COMMAND_ACK, msg->get_payload());
+            return;
+        }
+
+        if (call_it == pending_calls_.end())
+        {
+            lock.unlock();
+            spdlog::info("message_handler: message received!");
+            push_inbound(MiosChannel::COMMAND_ACK, msg->get_payload());
+            return;
+        }
+        spdlog::debug("message_handler: response for call {} ({}).", call_it->first, call_it->second.method);
+        call = std::move(call_it->second);
+        pending_calls_.erase(call_it);
+    }
+    complete_call(call, std::move(response));
+}
+
+/**
+ * @brief update the status of the connection and complete all the pending calls with std::nullopt,
+ * their responses can no longer arrive.
+ * ! the pending calls are not bound to a connection, the endpoint is meant for a single connection.
+ */
+void websocket_endpoint::on_connection_lost(connection_metadata::ptr metadata, websocketpp::connection_hdl hdl, bool isFailed)
+{
+    if (isFailed)
+    {
+        metadata->on_fail(&m_endpoint, hdl);
+    }
+    else
+    {
+        metadata->on_close(&m_endpoint, hdl);
+    }
+    std::size_t failed_count = fail_all_calls();
+    if (failed_count > 0)
+    {
+        spdlog::warn("connection {}: {} pending calls failed.", isFailed ? "failed" : "closed", failed_count);
+    }
+}
+
+/**
+ * @brief queue a message in its inbound channel. a full channel drops the message.
+ * the channels are only read by who asks for them, only the first drop is a warning.
+ */
+void websocket_endpoint::push_inbound(MiosChannel channel, const std::string &message)
+{
+    auto &inbound_channel = inbound_channels_[static_cast<std::size_t>(channel)];
+    if (!inbound_channel.push(message))
+    {
+        const std::uint64_t dropped_count = inbound_channel.get_dropped_count();
+        if (dropped_count == 1)
+        {
+            spdlog::warn("message_handler: the {} channel is full, message dropped.", get_mios_channel_name(channel));
+        }
+        else
+        {
+            spdlog::debug("message_handler: the {} channel is full, message dropped ({} dropped so far).",
+                          get_mios_channel_name(channel), dropped_count);
+        }
+    }
+}
+
+/**
+ * @brief hand the response to the waiter of the call. called without holding pending_mtx_.
+ *
+ * @param call
+ * @param response
+ */
+void websocket_endpoint::complete_call(PendingCall &call, std::optional<nlohmann::json> &&response)
+{
+    if (!call.callback)
+    {
+        call.promise.set_value(std::move(response));
+        return;
+    }
+    try
+    {
+        call.callback(std::move(response));
+    }
+    catch (const std::exception &e)
+    {
+        spdlog::error("complete_call: callback of {} threw: {}", call.method, e.what());
+    }
+    catch (...)
+    {
+        spdlog::error("complete_call: callback of {} threw an unknown exception.", call.method);
+    }
+}
+
+/**
+ * @brief add a call to the pending call table.
+ *
+ * @param method
+ * @param isMonitoring true for the long running calls, their responses go to the task result channel
+ * @param future the response of the call. std::nullopt if cancelled or not parsable.
+ * @return std::uint64_t the request id to send with the call
+ */
+std::uint64_t websocket_endpoint::register_call(const std::string &method, bool isMonitoring, std::future<std::optional<nlohmann::json>> &future)
+{
+    std::lock_guard<std::mutex> lock(pending_mtx_);
+    std::uint64_t request_id = m_next_request_id++;
+    PendingCall &call = pending_calls_[request_id];
+    call.method = method;
+    call.channel = isMonitoring ? MiosChannel::TASK_RESULT : get_mios_channel(method);
+    future = call.promise.get_future();
+    return request_id;
+}
+
+/**
+ * @brief add a call to the pending call table. the callback is run in the websocket thread
+ * when the response arrives or the call is cancelled, keep it short.
+ */
+std::uint64_t websocket_endpoint::register_call(const std::string &method, bool isMonitoring, std::function<void(std::optional<nlohmann::json>)> callback)
+{
+    std::lock_guard<std::mutex> lock(pending_mtx_);
+    std::uint64_t request_id = m_next_request_id++;
+    PendingCall &call = pending_calls_[request_id];
+    call.method = method;
+    call.channel = isMonitoring ? MiosChannel::TASK_RESULT : get_mios_channel(method);
+    call.callback = std::move(callback);
+    return request_id;
+}
+
+/**
+ * @brief remove a pending call. the waiting thread is woken up with std::nullopt.
+ *
+ * @param request_id
+ * @return true if the call was still pending
+ */
+bool websocket_endpoint::cancel_call(std::uint64_t request_id)
+{
+    PendingCall call;
+    {
+        std::lock_guard<std::mutex> lock(pending_mtx_);
+        auto call_it = pending_calls_.find(request_id);
+        if (call_it == pending_calls_.end())
+        {
+            return false;
+        }
+        call = std::move(call_it->second);
+        pending_calls_.erase(call_it);
+        // * its late response is recognized and dropped
+        cancelled_calls_[request_id] = call.channel;
+        if (cancelled_calls_.size() > kMaxCancelledCalls)
+        {
+            cancelled_calls_.erase(cancelled_calls_.begin());
+        }
+    }
+    complete_call(call, std::nullopt);
+    return true;
 }
 
-void websocket_endpoint::send(int id, const std::string &message)
+/**
+ * @brief remove a pending call whose request could not be sent. the waiter gets std::nullopt.
+ *
+ * @param request_id
+ * @return true if the call was still pending
+ */
+bool websocket_endpoint::fail_call(std::uint64_t request_id)
+{
+    PendingCall call;
+    {
+        std::lock_guard<std::mutex> lock(pending_mtx_);
+        auto call_it = pending_calls_.find(request_id);
+        if (call_it == pending_calls_.end())
+        {
+            return false;
+        }
+        call = std::move(call_it->second);
+        pending_calls_.erase(call_it);
+    }
+    complete_call(call, std::nullopt);
+    return true;
+}
+
+/**
+ * @brief complete all the pending calls with std::nullopt, e.g. when the connection is lost.
+ * the late responses of the cancelled calls can't arrive any more either.
+ *
+ * @return std::size_t number of failed calls
+ */
+std::size_t websocket_endpoint::fail_all_calls()
+{
+    std::map<std::uint64_t, PendingCall> calls;
+    {
+        std::lock_guard<std::mutex> lock(pending_mtx_);
+        calls.swap(pending_calls_);
+        cancelled_calls_.clear();
+    }
+    for (auto &call : calls)
+    {
+        complete_call(call.second, std::nullopt);
+    }
+    return calls.size();
+}
+
+std::size_t websocket_endpoint::get_pending_call_count()
+{
+    std::lock_guard<std::mutex> lock(pending_mtx_);
+    return pending_calls_.size();
+}
+
+/**
+ * @return true if the message was handed to the connection
+ */
+bool websocket_endpoint::send(int id, const std::string &message)
 {
     websocketpp::lib::error_code ec;
 
@@ -201,22 +514,23 @@ void websocket_endpoint::send(int id, const std::string &message)
         if (ec)
         {
             spdlog::error("> Error sending message: {}", ec.message());
+            return false;
         }
+        return true;
     }
     else
     {
         spdlog::error("> No connection found with id {}", id);
+        return false;
     }
 }
 
-ThreadSafeQueue<std::string> &websocket_endpoint::get_message_queue()
-{
-    return message_queue_;
-}
-
-void websocket_endpoint::reset_message_queue()
+/**
+ * @brief the queue of the messages of the channel that did not complete a pending call.
+ */
+ThreadSafeQueue<std::string> &websocket_endpoint::get_inbound_channel(MiosChannel channel)
 {
-    message_queue_.reset();
+    return inbound_channels_[static_cast<std::size_t>(channel)];
 }
 
 connection_metadata::ptr websocket_endpoint::get_metadata(int id)
@@ -637,33 +951,15 @@ std::optional<nlohmann::json> BTMessenger::stop_task_request()
  */
 std::optional<nlohmann::json> BTMessenger::start_task_request(nlohmann::json skill_context, std::string skill_type)
 {
-    // TODO
-    std::vector<std::string> skill_names;
-    std::vector<std::string> skill_types;
-    std::unordered_map<std::string, nlohmann::json> skill_contexts;
-
-    skill_names.push_back("BBSkill");
-    skill_types.push_back(skill_type);
-    skill_contexts["BBSkill"] = skill_context;
-
-    nlohmann::json task_context =
-        {{"parameters",
-          {{"skill_names", skill_names},
-           {"skill_types", skill_types},
-           {"as_queue", false}}},
-         {"skills", skill_contexts}};
-    nlohmann::json call_context =
-        {{"task", "GenericTask"},
-         {"parameters", task_context},
-         {"queue", true}};
-
-    // ! CHECK CONTEXT HERE
-    spdlog::warn("BB: DO CONTEXT CHECK HERE.");
-    spdlog::warn("BB: THE CONEXT IS: {}", call_context.dump());
-
     if (is_connected())
     {
-        return send_and_check("start_task", call_context);
+        auto handle = start_task_async(skill_context, skill_type);
+        auto response_opt = wait_for_call(handle, 1000);
+        if (!response_opt.has_value())
+        {
+            spdlog::error("Response of start_task timed out or not parsable.");
+        }
+        return response_opt;
     }
     else
     {
@@ -671,76 +967,52 @@ std::optional<nlohmann::json> BTMessenger::start_task_request(nlohmann::json ski
     }
 }
 
-void BTMessenger::start_and_monitor(const nlohmann::json &skill_context, std::string skill_type, std::promise<std::optional<nlohmann::json>> &task_promise, std::atomic_bool &isInterrupted)
+/**
+ * @brief send stop_task without waiting. see stop_task_request.
+ */
+PendingCallHandle BTMessenger::stop_task_async()
 {
-    // TODO
-    std::vector<std::string> skill_names;
-    std::vector<std::string> skill_types;
-    std::unordered_map<std::string, nlohmann::json> skill_contexts;
-
-    skill_names.push_back("BBSkill");
-    skill_types.push_back(skill_type);
-    skill_contexts["BBSkill"] = skill_context;
-
-    nlohmann::json task_context =
-        {{"parameters",
-          {{"skill_names", skill_names},
-           {"skill_types", skill_types},
-           {"as_queue", false}}},
-         {"skills", skill_contexts}};
-    nlohmann::json call_context =
-        {{"task", "GenericTask"},
-         {"parameters", task_context},
-         {"queue", true}};
+    nlohmann::json payload =
+        {{"raise_exception", false},
+         {"recover", false},
+         {"empty_queue", false}};
+    return call_async("stop_task", payload);
+}
 
-    // ! CHECK CONTEXT HERE
-    spdlog::warn("BB: THE CONEXT IS: {}", call_context.dump());
+/**
+ * @brief send start_task without waiting. see start_task_request.
+ */
+PendingCallHandle BTMessenger::start_task_async(const nlohmann::json &skill_context, const std::string &skill_type)
+{
+    PendingCallHandle handle;
+    handle.request_id = m_ws_endpoint.register_call("start_task", false, handle.result);
+    send_call(handle.request_id, make_task_frame("start_task", skill_context, skill_type, handle.request_id));
+    return handle;
+}
 
+/**
+ * @brief start the skill and block until mios reports the task result.
+ * the result is delivered the moment the response arrives. the interrupt flag is checked every
+ * kInterruptCheckPeriod, use start_and_monitor_async + cancel_call for an immediate wake up.
+ *
+ * @param skill_context
+ * @param skill_type
+ * @param task_promise
+ * @param isInterrupted
+ */
+void BTMessenger::start_and_monitor(const nlohmann::json &skill_context, std::string skill_type, std::promise<std::optional<nlohmann::json>> &task_promise, std::atomic_bool &isInterrupted)
+{
     // ! test
     if (is_connected())
     {
-        m_ws_endpoint.get_message_queue().reset();
-        send("start_and_monitor", call_context);
-
-        std::optional<std::string> response_opt;
-
-        while (!response_opt.has_value())
-        {
-            if (isInterrupted.load()) // * if interrupted, return
-            {
-                spdlog::warn("wait_for_task_result: interrupted.");
-                task_promise.set_value(std::nullopt);
-                return;
-            }
-            // * try to get the value again
-            response_opt = m_ws_endpoint.get_message_queue().pop();
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        }
-        try
-        {
-            nlohmann::json result = std::move(nlohmann::json::parse(response_opt.value()));
-            // The parsing succeeded, the data is JSON.
-            spdlog::info("Call method wait_for_task get response if_success: {}", result["result"]["result"].dump());
-            task_promise.set_value(result);
-            return;
-        }
-        catch (nlohmann::json::parse_error &e)
-        {
-            spdlog::error("JSON parsing failed: ", e.what());
-            task_promise.set_value(std::nullopt);
-            return;
-        }
-        catch (...)
-        {
-            spdlog::error("wait for task: UNDEFINED ERROR!");
-            task_promise.set_value(std::nullopt);
-            return;
-        }
+        PendingCallHandle handle;
+        handle.request_id = m_ws_endpoint.register_call("start_and_monitor", true, handle.result);
+        send_call(handle.request_id, make_task_frame("start_and_monitor", skill_context, skill_type, handle.request_id));
+        task_promise.set_value(wait_interruptible(handle, isInterrupted));
     }
     else
     {
         task_promise.set_value(std::nullopt);
-        return;
     }
 }
 
@@ -750,51 +1022,215 @@ void BTMessenger::wait_for_task_result(int task_uuid, std::promise<std::optional
     // ! test
     if (is_connected())
     {
-        m_ws_endpoint.get_message_queue().reset();
+        auto handle = wait_for_task_result_async(task_uuid);
+        task_promise.set_value(wait_interruptible(handle, isInterrupted));
+    }
+    else
+    {
+        task_promise.set_value(std::nullopt);
+    }
+}
 
-        // ? implicit transform?
-        send("wait_for_task", task_uuid);
+/**
+ * @brief start the skill and return at once. the callback is called with the task result,
+ * or with std::nullopt when the call is cancelled with cancel_call(request_id).
+ *
+ * @return std::uint64_t the request id of the call
+ */
+std::uint64_t BTMessenger::start_and_monitor_async(const nlohmann::json &skill_context, const std::string &skill_type, CallResultCallback callback)
+{
+    std::uint64_t request_id = m_ws_endpoint.register_call("start_and_monitor", true, std::move(callback));
+    send_call(request_id, make_task_frame("start_and_monitor", skill_context, skill_type, request_id));
+    return request_id;
+}
 
-        std::optional<std::string> response_opt;
+/**
+ * @brief wait for the result of a running task without blocking. cancel with cancel_task_wait(task_uuid).
+ *
+ * @return std::uint64_t the request id of the call
+ */
+std::uint64_t BTMessenger::wait_for_task_result_async(int task_uuid, CallResultCallback callback)
+{
+    // * set under task_waits_mtx_, the callback reads it under the same lock
+    auto request_id_ptr = std::make_shared<std::uint64_t>(0);
+    std::uint64_t request_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(task_waits_mtx_);
+        request_id = m_ws_endpoint.register_call("wait_for_task", true,
+                                                 [this, task_uuid, request_id_ptr, callback = std::move(callback)](std::optional<nlohmann::json> result)
+                                                 {
+                                                     forget_task_wait(task_uuid, request_id_ptr);
+                                                     callback(std::move(result));
+                                                 });
+        *request_id_ptr = request_id;
+        task_waits_[task_uuid] = request_id;
+    }
+    // * outside the lock, a failed send completes the call in this thread
+    send_call(request_id, make_call_frame("wait_for_task", task_uuid, request_id));
+    return request_id;
+}
 
-        while (!response_opt.has_value())
+PendingCallHandle BTMessenger::wait_for_task_result_async(int task_uuid)
+{
+    auto promise = std::make_shared<std::promise<std::optional<nlohmann::json>>>();
+    PendingCallHandle handle;
+    handle.result = promise->get_future();
+    handle.request_id = wait_for_task_result_async(task_uuid, [promise](std::optional<nlohmann::json> result)
+                                                   { promise->set_value(std::move(result)); });
+    return handle;
+}
+
+/**
+ * @brief wake up the waiter of the task at once with std::nullopt.
+ *
+ * @param task_uuid
+ * @return true if a wait was pending
+ */
+bool BTMessenger::cancel_task_wait(int task_uuid)
+{
+    std::uint64_t request_id = 0;
+    {
+        std::lock_guard<std::mutex> lock(task_waits_mtx_);
+        auto it = task_waits_.find(task_uuid);
+        if (it == task_waits_.end())
         {
-            if (isInterrupted) // * if interrupted, return
-            {
-                spdlog::warn("wait_for_task_result: interrupted.");
-                task_promise.set_value(std::nullopt);
-                return;
-            }
-            // * try to get the value again
-            response_opt = m_ws_endpoint.get_message_queue().pop();
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            return false;
         }
-        try
+        request_id = it->second;
+        task_waits_.erase(it);
+    }
+    return m_ws_endpoint.cancel_call(request_id);
+}
+
+/**
+ * @brief remove the wait of the task, unless a newer wait was registered for the same task since.
+ */
+void BTMessenger::forget_task_wait(int task_uuid, const std::shared_ptr<std::uint64_t> &request_id_ptr)
+{
+    std::lock_guard<std::mutex> lock(task_waits_mtx_);
+    auto it = task_waits_.find(task_uuid);
+    if (it != task_waits_.end() && it->second == *request_id_ptr)
+    {
+        task_waits_.erase(it);
+    }
+}
+
+/**
+ * @brief block on the call until its response arrives or the flag is set.
+ */
+std::optional<nlohmann::json> BTMessenger::wait_interruptible(PendingCallHandle &handle, std::atomic_bool &isInterrupted)
+{
+    while (handle.result.wait_for(kInterruptCheckPeriod) != std::future_status::ready)
+    {
+        if (isInterrupted.load()) // * if interrupted, return
         {
-            nlohmann::json result = std::move(nlohmann::json::parse(response_opt.value()));
-            // The parsing succeeded, the data is JSON.
-            spdlog::info("Call method wait_for_task get response if_success: {}", result["result"]["result"].dump());
-            task_promise.set_value(result);
-            return;
+            spdlog::warn("wait_for_task_result: interrupted.");
+            m_ws_endpoint.cancel_call(handle.request_id);
+            break;
         }
-        catch (nlohmann::json::parse_error &e)
+    }
+    auto result = handle.result.get();
+    if (result.has_value())
+    {
+        try
         {
-            spdlog::error("JSON parsing failed: ", e.what());
-            task_promise.set_value(std::nullopt);
-            return;
+            spdlog::info("Call method wait_for_task get response if_success: {}", result.value()["result"]["result"].dump());
         }
         catch (...)
         {
             spdlog::error("wait for task: UNDEFINED ERROR!");
-            task_promise.set_value(std::nullopt);
-            return;
         }
     }
-    else
+    return result;
+}
+
+/**
+ * @brief the mios "GenericTask" call context with a single skill.
+ */
+nlohmann::json BTMessenger::make_task_context(const nlohmann::json &skill_context, const std::string &skill_type)
+{
+    nlohmann::json task_context =
+        {{"parameters",
+          {{"skill_names", {"BBSkill"}},
+           {"skill_types", {skill_type}},
+           {"as_queue", false}}},
+         {"skills", {{"BBSkill", skill_context}}}};
+    nlohmann::json call_context =
+        {{"task", "GenericTask"},
+         {"parameters", task_context},
+         {"queue", true}};
+    return call_context;
+}
+
+/**
+ * @brief serialize the call frame once with a placeholder for the skill context and split it there.
+ */
+BTMessenger::TaskEnvelope BTMessenger::make_task_envelope(const std::string &method, const std::string &skill_type)
+{
+    static const std::string placeholder = "__kios_skill_context__";
+    nlohmann::json request;
+    request["method"] = method;
+    request["request"] = make_task_context(placeholder, skill_type);
+    std::string frame = request.dump();
+
+    const std::string quoted_placeholder = "\"" + placeholder + "\"";
+    std::size_t position = frame.find(quoted_placeholder);
+    TaskEnvelope envelope;
+    envelope.prefix = frame.substr(0, position);
+    // * drop the closing brace, the request id is appended per call
+    envelope.suffix = frame.substr(position + quoted_placeholder.size());
+    envelope.suffix.pop_back();
+    envelope.suffix += ",\"request_id\":";
+    return envelope;
+}
+
+/**
+ * @brief build the task envelopes of the given mios skill types for start_task and start_and_monitor.
+ * call this once after connecting. skill types not prepared here are cached on first use.
+ *
+ * @param skill_types
+ */
+void BTMessenger::prepare_task_templates(const std::vector<std::string> &skill_types)
+{
+    std::lock_guard<std::mutex> lock(task_templates_mtx_);
+    for (const auto &skill_type : skill_types)
     {
-        task_promise.set_value(std::nullopt);
-        return;
+        if (skill_type.empty())
+        {
+            continue;
+        }
+        for (const std::string method : {"start_task", "start_and_monitor"})
+        {
+            task_templates_.try_emplace(method + "/" + skill_type, make_task_envelope(method, skill_type));
+        }
+    }
+    spdlog::info("prepare_task_templates: {} task envelopes ready.", task_templates_.size());
+}
+
+/**
+ * @brief the serialized call frame. only the skill context is serialized per call.
+ */
+std::string BTMessenger::make_task_frame(const std::string &method, const nlohmann::json &skill_context, const std::string &skill_type, std::uint64_t request_id)
+{
+    std::string skill_context_dump = skill_context.dump();
+    std::string frame;
+    {
+        std::lock_guard<std::mutex> lock(task_templates_mtx_);
+        auto it = task_templates_.find(method + "/" + skill_type);
+        if (it == task_templates_.end())
+        {
+            it = task_templates_.emplace(method + "/" + skill_type, make_task_envelope(method, skill_type)).first;
+        }
+        const TaskEnvelope &envelope = it->second;
+        frame.reserve(envelope.prefix.size() + skill_context_dump.size() + envelope.suffix.size() + 24);
+        frame += envelope.prefix;
+        frame += skill_context_dump;
+        frame += envelope.suffix;
     }
+    frame += std::to_string(request_id);
+    frame += '}';
+    spdlog::debug("BB: task frame: {}", frame);
+    return frame;
 }
 
 /**
@@ -807,20 +1243,13 @@ void BTMessenger::wait_for_task_result(int task_uuid, std::promise<std::optional
  */
 void BTMessenger::send_and_wait(const std::string &method, nlohmann::json payload, int timeout, bool silent)
 {
-    send(method, payload);
-    auto response_opt = m_ws_endpoint.get_message_queue().pop();
+    auto response_opt = send_and_check(method, payload, std::max(timeout, 1000), silent);
 
     if (response_opt.has_value())
     {
         try
         {
-            nlohmann::json result = nlohmann::json::parse(response_opt.value());
-
-            spdlog::info("Call method {} get response if_success: {}", method, result["result"]["result"].dump());
-        }
-        catch (nlohmann::json::parse_error &e)
-        {
-            spdlog::error("JSON parsing failed: {}", e.what());
+            spdlog::info("Call method {} get response if_success: {}", method, response_opt.value()["result"]["result"].dump());
         }
         catch (...)
         {
@@ -837,50 +1266,107 @@ void BTMessenger::send_and_wait(const std::string &method, nlohmann::json payloa
  * @brief "call_method" and check result.
  * @param method
  * @param payload
- * @param timeout
+ * @param timeout in ms
  * @param silent
  */
 std::optional<nlohmann::json> BTMessenger::send_and_check(const std::string &method, nlohmann::json payload, int timeout, bool silent)
 {
-    m_ws_endpoint.get_message_queue().reset();
-    send(method, payload);
+    auto handle = call_async(method, payload);
+    auto response_opt = wait_for_call(handle, timeout);
+    if (!response_opt.has_value())
+    {
+        spdlog::error("Response of {} timed out or not parsable.", method);
+    }
+    return response_opt;
+}
+
+/**
+ * @brief send a call with a new request id without waiting. several calls can be in flight at the same time.
+ *
+ * @param method
+ * @param payload
+ * @param isMonitoring true for the long running calls whose response comes when the task is finished
+ * @return PendingCallHandle the request id and the future of the response
+ */
+PendingCallHandle BTMessenger::call_async(const std::string &method, const nlohmann::json &payload, bool isMonitoring)
+{
+    PendingCallHandle handle;
+    handle.request_id = m_ws_endpoint.register_call(method, isMonitoring, handle.result);
+    send_call(handle.request_id, make_call_frame(method, payload, handle.request_id));
+    return handle;
+}
 
-    auto response_opt = m_ws_endpoint.get_message_queue().pop();
+/**
+ * @brief send a call whose response is handed to the callback in the websocket thread.
+ *
+ * @return std::uint64_t the request id, for cancel_call
+ */
+std::uint64_t BTMessenger::call_async(const std::string &method, const nlohmann::json &payload, bool isMonitoring, CallResultCallback callback)
+{
+    std::uint64_t request_id = m_ws_endpoint.register_call(method, isMonitoring, std::move(callback));
+    send_call(request_id, make_call_frame(method, payload, request_id));
+    return request_id;
+}
 
-    if (response_opt.has_value())
+std::string BTMessenger::make_call_frame(const std::string &method, const nlohmann::json &payload, std::uint64_t request_id)
+{
+    nlohmann::json request;
+    request["method"] = method;
+    request["request"] = payload;
+    request["request_id"] = request_id;
+    return request.dump();
+}
+
+/**
+ * @brief send the frame of a registered call. if it cannot be sent the call is completed at once with std::nullopt,
+ * in this thread.
+ *
+ * @return true if sent
+ */
+bool BTMessenger::send_call(std::uint64_t request_id, const std::string &frame)
+{
+    if (m_ws_endpoint.send(connection_id, frame))
     {
-        try
-        {
-            nlohmann::json result = nlohmann::json::parse(response_opt.value());
-            return result;
-            // The parsing succeeded, the data is JSON.
-            // spdlog::info("Call method ", method, " get response if_success: {}", result["result"]["result"].dump());
-            // if (static_cast<bool>(result["result"]["result"]) == true)
-            // {
-            //     return true;
-            // }
-            // else if (static_cast<bool>(result["result"]["result"]) == false)
-            // {
-            //     spdlog::error("Error message: {}", result["result"]["error"].dump());
-            //     return false;
-            // }
-        }
-        catch (nlohmann::json::parse_error &e)
-        {
-            spdlog::error("JSON parsing failed: ", e.what());
-            return std::nullopt;
-        }
-        catch (...)
-        {
-            spdlog::error("SEND_AND_WAIT: UNDEFINED ERROR!");
-            return std::nullopt;
-        }
+        return true;
     }
-    else
+    m_ws_endpoint.fail_call(request_id);
+    return false;
+}
+
+/**
+ * @brief wait for the response of a call. the call is cancelled when timed out.
+ *
+ * @param handle
+ * @param timeout in ms
+ * @return std::optional<nlohmann::json> std::nullopt if timed out, cancelled or not parsable
+ */
+std::optional<nlohmann::json> BTMessenger::wait_for_call(PendingCallHandle &handle, int timeout)
+{
+    if (!handle.result.valid())
     {
-        spdlog::error("Response timed out, waiting skipped.");
         return std::nullopt;
     }
+    if (handle.result.wait_for(std::chrono::milliseconds(timeout)) != std::future_status::ready)
+    {
+        m_ws_endpoint.cancel_call(handle.request_id);
+    }
+    return handle.result.get();
+}
+
+/**
+ * @brief cancel a pending call. its waiter gets std::nullopt at once.
+ *
+ * @param request_id
+ * @return true if the call was still pending
+ */
+bool BTMessenger::cancel_call(std::uint64_t request_id)
+{
+    return m_ws_endpoint.cancel_call(request_id);
+}
+
+ThreadSafeQueue<std::string> &BTMessenger::get_inbound_channel(MiosChannel channel)
+{
+    return m_ws_endpoint.get_inbound_channel(channel);
 }
 
 [[maybe_unused]] void BTMessenger::set_message_handler(std::function<void(const std::string &)> handler)
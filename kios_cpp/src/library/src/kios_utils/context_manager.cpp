@@ -8,7 +8,8 @@ namespace kios
           default_file_name("context_archive.json"),
           dump_file_name("dump_context_archive.json"),
           file_name("context_archive.json"),
-          default_context_dictionary_ptr_(std::make_unique<DefaultActionContext>())
+          default_context_dictionary_ptr_(std::make_unique<DefaultActionContext>()),
+          context_version_(0)
     {
         // ! wahrscheinlich noch fehlerhaft
         logger = set_logger("ContextClerk", "debug");
@@ -81,6 +82,7 @@ namespace kios
                 auto &context_pair = group_dictionary[action_id];
                 // insert pair
                 context_pair = std::make_pair(description, context.value());
+                context_version_++;
             }
             else
             {
@@ -195,6 +197,8 @@ namespace kios
             return false;
         }
 
+        context_version_++;
+
         // ! test
         std::cout << "the read dictionary is: " << action_ground_dictionary_ << std::endl;
 
@@ -220,4 +224,9 @@ namespace kios
         return {};
     }
 
+    std::uint64_t ContextClerk::get_context_version() const
+    {
+        return context_version_;
+    }
+
 } // namespace kios
@@ -0,0 +1,85 @@
+#include "kios_utils/skill_parameter_cache.hpp"
+
+namespace kios
+{
+    SkillParameterCache::SkillParameterCache()
+        : cache_(),
+          hit_count_(0),
+          miss_count_(0)
+    {
+    }
+
+    /**
+     * @brief find the parameter of the action node.
+     *
+     * @param archive
+     * @param object_names
+     * @param context_version the latest context version published by the tactician
+     * @param parameter output
+     * @return true if a valid entry is found
+     */
+    bool SkillParameterCache::lookup(const NodeArchive &archive, const std::vector<std::string> &object_names, std::uint64_t context_version, CachedSkillParameter &parameter)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = cache_.find(Key(archive.action_group, archive.action_id, object_names));
+        if (it == cache_.end() || it->second.context_version != context_version)
+        {
+            miss_count_++;
+            return false;
+        }
+        hit_count_++;
+        parameter = it->second;
+        return true;
+    }
+
+    void SkillParameterCache::store(const NodeArchive &archive, const std::vector<std::string> &object_names, const CachedSkillParameter &parameter)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        cache_[Key(archive.action_group, archive.action_id, object_names)] = parameter;
+    }
+
+    /**
+     * @brief drop all the entries that are not of the given context version.
+     *
+     * @param context_version
+     */
+    void SkillParameterCache::invalidate(std::uint64_t context_version)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto it = cache_.begin(); it != cache_.end();)
+        {
+            if (it->second.context_version != context_version)
+            {
+                it = cache_.erase(it);
+            }
+            else
+            {
+                it++;
+            }
+        }
+    }
+
+    void SkillParameterCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        cache_.clear();
+    }
+
+    std::size_t SkillParameterCache::size()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return cache_.size();
+    }
+
+    std::uint64_t SkillParameterCache::get_hit_count()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return hit_count_;
+    }
+
+    std::uint64_t SkillParameterCache::get_miss_count()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return miss_count_;
+    }
+} // namespace kios
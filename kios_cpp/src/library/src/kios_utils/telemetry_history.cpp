@@ -0,0 +1,135 @@
+#include "kios_utils/telemetry_history.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace kios
+{
+    TelemetryWindow merge_telemetry_windows(const TelemetryWindow &older, const TelemetryWindow &newer)
+    {
+        if (older.sample_count == 0)
+        {
+            return newer;
+        }
+        if (newer.sample_count == 0)
+        {
+            // * keep the newest last value
+            TelemetryWindow result = older;
+            result.tf_f_ext_k_last = newer.tf_f_ext_k_last;
+            return result;
+        }
+        TelemetryWindow result;
+        result.sample_count = older.sample_count + newer.sample_count;
+        result.window_duration = older.window_duration + newer.window_duration;
+        for (std::size_t i = 0; i < result.tf_f_ext_k_max_abs.size(); i++)
+        {
+            result.tf_f_ext_k_max_abs[i] = std::max(older.tf_f_ext_k_max_abs[i], newer.tf_f_ext_k_max_abs[i]);
+            result.tf_f_ext_k_mean[i] = (older.tf_f_ext_k_mean[i] * older.sample_count +
+                                         newer.tf_f_ext_k_mean[i] * newer.sample_count) /
+                                        result.sample_count;
+        }
+        result.tf_f_ext_k_last = newer.tf_f_ext_k_last;
+        result.f_ext_max_norm = std::max(older.f_ext_max_norm, newer.f_ext_max_norm);
+        return result;
+    }
+
+    TelemetryHistory::TelemetryHistory(std::size_t depth)
+        : samples_(std::max<std::size_t>(depth, 1)),
+          head_(0),
+          count_(0),
+          pushed_count_(0)
+    {
+    }
+
+    /**
+     * @brief record a new wrench sample. missing components are set to zero, extra ones are ignored.
+     *
+     * @param tf_f_ext_k
+     * @param size
+     * @param stamp receive time
+     */
+    void TelemetryHistory::push(const double *tf_f_ext_k, std::size_t size, Clock::time_point stamp)
+    {
+        Sample &sample = samples_[head_];
+        sample.stamp = stamp;
+        for (std::size_t i = 0; i < sample.tf_f_ext_k.size(); i++)
+        {
+            sample.tf_f_ext_k[i] = i < size ? tf_f_ext_k[i] : 0;
+        }
+        head_ = (head_ + 1) % samples_.size();
+        count_ = std::min(count_ + 1, samples_.size());
+        pushed_count_++;
+    }
+
+    /**
+     * @brief aggregate the samples received in the last window. the last value is always the newest
+     * sample, also when it is older than the window.
+     *
+     * @param window
+     * @param now
+     * @return TelemetryWindow
+     */
+    TelemetryWindow TelemetryHistory::aggregate(std::chrono::milliseconds window, Clock::time_point now) const
+    {
+        TelemetryWindow result;
+        if (count_ == 0)
+        {
+            return result;
+        }
+        const std::size_t newest = (head_ + samples_.size() - 1) % samples_.size();
+        result.tf_f_ext_k_last = samples_[newest].tf_f_ext_k;
+
+        const Clock::time_point since = now - window;
+        Clock::time_point oldest_stamp = samples_[newest].stamp;
+        // * walk back from the newest sample until the window is left
+        for (std::size_t n = 0; n < count_; n++)
+        {
+            const Sample &sample = samples_[(newest + samples_.size() - n) % samples_.size()];
+            if (sample.stamp < since)
+            {
+                break;
+            }
+            for (std::size_t i = 0; i < sample.tf_f_ext_k.size(); i++)
+            {
+                result.tf_f_ext_k_max_abs[i] = std::max(result.tf_f_ext_k_max_abs[i], std::abs(sample.tf_f_ext_k[i]));
+                result.tf_f_ext_k_mean[i] += sample.tf_f_ext_k[i];
+            }
+            const double norm = std::sqrt(sample.tf_f_ext_k[0] * sample.tf_f_ext_k[0] +
+                                          sample.tf_f_ext_k[1] * sample.tf_f_ext_k[1] +
+                                          sample.tf_f_ext_k[2] * sample.tf_f_ext_k[2]);
+            result.f_ext_max_norm = std::max(result.f_ext_max_norm, norm);
+            oldest_stamp = sample.stamp;
+            result.sample_count++;
+        }
+        if (result.sample_count > 0)
+        {
+            for (auto &mean : result.tf_f_ext_k_mean)
+            {
+                mean /= result.sample_count;
+            }
+            result.window_duration = std::chrono::duration<double>(samples_[newest].stamp - oldest_stamp).count();
+        }
+        return result;
+    }
+
+    void TelemetryHistory::clear()
+    {
+        head_ = 0;
+        count_ = 0;
+    }
+
+    std::size_t TelemetryHistory::depth() const
+    {
+        return samples_.size();
+    }
+
+    std::size_t TelemetryHistory::size() const
+    {
+        return count_;
+    }
+
+    std::uint64_t TelemetryHistory::get_pushed_count() const
+    {
+        return pushed_count_;
+    }
+} // namespace kios
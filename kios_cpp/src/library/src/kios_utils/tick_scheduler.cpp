@@ -0,0 +1,98 @@
+#include "kios_utils/tick_scheduler.hpp"
+
+namespace kios
+{
+    TickScheduler::TickScheduler(std::function<void()> tick_callback, std::chrono::milliseconds max_tick_period)
+        : tick_callback_(std::move(tick_callback)),
+          max_tick_period_(max_tick_period),
+          stopThread(true),
+          hasPendingEvent(false)
+    {
+    }
+
+    TickScheduler::~TickScheduler()
+    {
+        stop();
+    }
+
+    bool TickScheduler::start()
+    {
+        if (!stopThread.load())
+        {
+            // already running
+            return true;
+        }
+        stopThread.store(false);
+        try
+        {
+            tickThread = std::thread(&TickScheduler::tick_loop, this);
+        }
+        catch (...)
+        {
+            stopThread.store(true);
+            return false;
+        }
+        return true;
+    }
+
+    void TickScheduler::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopThread.store(true);
+        }
+        cv.notify_one();
+        if (tickThread.joinable() && tickThread.get_id() != std::this_thread::get_id())
+        {
+            tickThread.join();
+        }
+    }
+
+    bool TickScheduler::is_running()
+    {
+        return !stopThread.load();
+    }
+
+    /**
+     * @brief mark a pending event and wake up the tick thread. events that arrive during a tick are
+     * not lost: the next tick is then run immediately after the current one.
+     */
+    void TickScheduler::notify()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            hasPendingEvent = true;
+        }
+        cv.notify_one();
+    }
+
+    void TickScheduler::set_max_tick_period(std::chrono::milliseconds max_tick_period)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        max_tick_period_ = max_tick_period;
+    }
+
+    std::chrono::milliseconds TickScheduler::get_max_tick_period()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return max_tick_period_;
+    }
+
+    void TickScheduler::tick_loop()
+    {
+        while (!stopThread.load())
+        {
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait_for(lock, max_tick_period_, [this]() { return hasPendingEvent || stopThread.load(); });
+                if (stopThread.load())
+                {
+                    return;
+                }
+                // * consume the event (or the timeout) before ticking
+                hasPendingEvent = false;
+            }
+            tick_callback_();
+        }
+    }
+} // namespace kios
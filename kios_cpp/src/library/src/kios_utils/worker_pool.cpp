@@ -0,0 +1,154 @@
+#include "kios_utils/worker_pool.hpp"
+
+#include <algorithm>
+
+namespace kios
+{
+    WorkerPool::WorkerPool(std::size_t worker_count)
+        : stopThread(false),
+          generation_(0),
+          active_count_(0),
+          job_(nullptr),
+          job_count_(0),
+          chunk_size_(1),
+          next_index_(0),
+          first_error_index_(0)
+    {
+        threads_.reserve(worker_count);
+        for (std::size_t i = 0; i < worker_count; i++)
+        {
+            threads_.emplace_back(&WorkerPool::worker_loop, this);
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            stopThread = true;
+        }
+        job_cv_.notify_all();
+        for (auto &thread : threads_)
+        {
+            if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
+    }
+
+    /**
+     * @brief one thread less than the cores, the caller is the last one.
+     */
+    std::size_t WorkerPool::get_default_worker_count()
+    {
+        const unsigned int cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 0;
+    }
+
+    void WorkerPool::parallel_for(std::size_t count, const std::function<void(std::size_t)> &fn, std::size_t min_chunk)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> run_lock(run_mtx_);
+        first_error_ = nullptr;
+
+        if (threads_.empty() || count <= min_chunk)
+        {
+            job_count_ = count;
+            chunk_size_ = count;
+            next_index_.store(0);
+            run_chunks(fn);
+        }
+        else
+        {
+            {
+                std::lock_guard<std::mutex> lock(mtx_);
+                job_ = &fn;
+                job_count_ = count;
+                // * a few chunks per thread to even out nodes of different cost
+                chunk_size_ = std::max<std::size_t>(1, count / ((threads_.size() + 1) * 4));
+                next_index_.store(0);
+                generation_++;
+            }
+            job_cv_.notify_all();
+            run_chunks(fn);
+
+            std::unique_lock<std::mutex> lock(mtx_);
+            done_cv_.wait(lock, [this]()
+                          { return active_count_ == 0; });
+            // * the workers that wake up from now on find no job
+            job_ = nullptr;
+        }
+
+        if (first_error_)
+        {
+            std::exception_ptr error = first_error_;
+            first_error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    void WorkerPool::worker_loop()
+    {
+        std::uint64_t seen_generation = 0;
+        std::unique_lock<std::mutex> lock(mtx_);
+        while (true)
+        {
+            job_cv_.wait(lock, [&]()
+                         { return stopThread || generation_ != seen_generation; });
+            if (stopThread)
+            {
+                return;
+            }
+            seen_generation = generation_;
+            if (job_ == nullptr)
+            {
+                continue;
+            }
+            const std::function<void(std::size_t)> *job = job_;
+            active_count_++;
+            lock.unlock();
+
+            run_chunks(*job);
+
+            lock.lock();
+            active_count_--;
+            if (active_count_ == 0)
+            {
+                done_cv_.notify_all();
+            }
+        }
+    }
+
+    void WorkerPool::run_chunks(const std::function<void(std::size_t)> &fn)
+    {
+        while (true)
+        {
+            const std::size_t begin = next_index_.fetch_add(chunk_size_);
+            if (begin >= job_count_)
+            {
+                return;
+            }
+            const std::size_t end = std::min(begin + chunk_size_, job_count_);
+            for (std::size_t i = begin; i < end; i++)
+            {
+                try
+                {
+                    fn(i);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(error_mtx_);
+                    if (!first_error_ || i < first_error_index_)
+                    {
+                        first_error_ = std::current_exception();
+                        first_error_index_ = i;
+                    }
+                }
+            }
+        }
+    }
+} // namespace kios
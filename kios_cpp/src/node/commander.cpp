@@ -1,9 +1,11 @@
 
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <rclcpp/logging.hpp>
 
 #include "rclcpp/rclcpp.hpp"
+#include "rclcpp_components/register_node_macro.hpp"
 
 #include "nlohmann/json.hpp"
 
@@ -11,6 +13,8 @@
 #include "rcl_interfaces/srv/get_parameters.hpp"
 #include "rcl_interfaces/msg/parameter.hpp"
 
+#include "std_msgs/msg/float64.hpp"
+
 #include "behavior_tree/tree_root.hpp"
 
 #include "kios_communication/ws_client.hpp"
@@ -33,6 +37,10 @@ public:
           udp_port_(12346),
           subscription_list_{"tau_ext", "q", "TF_F_ext_K", "system_time", "T_T_EE"}
     {
+        // * send stop and start back-to-back for STOP_OLD_START_NEW
+        this->declare_parameter("pipelined_transition", true);
+        this->declare_parameter("transition_timeout_ms", 1000);
+
         // callback group
         service_callback_group_ = this->create_callback_group(
             rclcpp::CallbackGroupType::MutuallyExclusive);
@@ -54,6 +62,9 @@ public:
         // udp register
         mios_register_udp(udp_port_, subscription_list_);
 
+        // * serialize the task envelopes of the mios skills once
+        prepare_task_templates();
+
         // * initialize service
         command_service_ = this->create_service<kios_interface::srv::CommandRequest>(
             "command_request_service",
@@ -67,6 +78,15 @@ public:
             std::bind(&Commander::teach_object_service_callback, this, _1, _2),
             rmw_qos_profile_services_default,
             service_callback_group_);
+
+        // * stop-old/start-new latency of each pipelined transition in ms
+        switch_latency_publisher_ = this->create_publisher<std_msgs::msg::Float64>("switch_latency_topic", 10);
+    }
+
+    ~Commander()
+    {
+        // * unregister the udp before shutdown. also when unloaded from a component container.
+        shut_down_connection();
     }
 
     // connection rel
@@ -79,6 +99,24 @@ public:
         messenger_->unregister_udp();
     }
 
+    void prepare_task_templates()
+    {
+        std::vector<std::string> skill_types;
+        for (const auto action_phase : {kios::ActionPhase::CARTESIAN_MOVE,
+                                        kios::ActionPhase::JOINT_MOVE,
+                                        kios::ActionPhase::GRIPPER_FORCE,
+                                        kios::ActionPhase::GRIPPER_MOVE,
+                                        kios::ActionPhase::CONTACT,
+                                        kios::ActionPhase::WIGGLE,
+                                        kios::ActionPhase::TOOL_LOAD,
+                                        kios::ActionPhase::TOOL_PICK,
+                                        kios::ActionPhase::TOOL_PLACE})
+        {
+            skill_types.push_back(kios::ap_to_mios_skill(action_phase));
+        }
+        messenger_->prepare_task_templates(skill_types);
+    }
+
     void shut_down_connection()
     {
         messenger_->unregister_udp();
@@ -107,6 +145,8 @@ private:
     int udp_port_;
     nlohmann::json subscription_list_;
 
+    rclcpp::Publisher<std_msgs::msg::Float64>::SharedPtr switch_latency_publisher_;
+
     void command_service_callback(
         const std::shared_ptr<kios_interface::srv::CommandRequest::Request> request,
         const std::shared_ptr<kios_interface::srv::CommandRequest::Response> response)
@@ -116,7 +156,14 @@ private:
         command_request_.command_type = static_cast<kios::CommandType>(request->command_type);
         try
         {
-            command_request_.command_context = nlohmann::json::parse(request->command_context);
+            if (!request->command_context_cbor.empty())
+            {
+                command_request_.command_context = nlohmann::json::from_cbor(request->command_context_cbor);
+            }
+            else
+            {
+                command_request_.command_context = nlohmann::json::parse(request->command_context);
+            }
         }
         catch (...)
         {
@@ -139,7 +186,11 @@ private:
         }
         case kios::CommandType::STOP_OLD_START_NEW: {
             RCLCPP_INFO(this->get_logger(), "Issuing command: stop old start new...");
-            if (stop_task_request() == true)
+            if (this->get_parameter("pipelined_transition").as_bool())
+            {
+                stop_old_start_new(command_request);
+            }
+            else if (stop_task_request() == true)
             {
                 start_task_request(command_request);
             }
@@ -210,6 +261,60 @@ private:
         }
     }
 
+    /**
+     * @brief pipelined transition. the stop frame is sent first, the new task context is built while
+     * it is in flight and the start frame follows immediately. the two responses are checked independently.
+     * unlike the sequential transition the start is sent before the stop is confirmed. if mios refuses the stop
+     * but accepts the start, the new task is stopped again so it does not run beside the old one.
+     * the switch latency (until the start ack) is published on switch_latency_topic.
+     *
+     * @param request
+     * @return true if both stop and start are accepted by mios
+     */
+    bool stop_old_start_new(const kios::CommandRequest &request)
+    {
+        const int timeout = this->get_parameter("transition_timeout_ms").as_int();
+        auto switch_start = std::chrono::steady_clock::now();
+
+        auto stop_handle = messenger_->stop_task_async();
+        auto start_handle = messenger_->start_task_async(request.command_context, request.skill_type);
+
+        bool isStopped = messenger_->get_result(messenger_->wait_for_call(stop_handle, timeout));
+        auto stop_done = std::chrono::steady_clock::now();
+
+        auto start_result = messenger_->wait_for_call(start_handle, timeout);
+        auto start_done = std::chrono::steady_clock::now();
+        if (start_result.has_value())
+        {
+            task_response_ = start_result.value();
+        }
+        bool isStarted = messenger_->get_result(std::move(start_result));
+
+        std_msgs::msg::Float64 switch_latency;
+        switch_latency.data = std::chrono::duration<double, std::milli>(start_done - switch_start).count();
+        RCLCPP_INFO(this->get_logger(), "stop old start new: stop %s after %.2f ms, start %s after %.2f ms.",
+                    isStopped ? "accepted" : "FAILED",
+                    std::chrono::duration<double, std::milli>(stop_done - switch_start).count(),
+                    isStarted ? "accepted" : "FAILED",
+                    switch_latency.data);
+        switch_latency_publisher_->publish(switch_latency);
+        if (!isStopped && isStarted)
+        {
+            // * the old task may still be running, do not leave the new one beside it
+            RCLCPP_ERROR(this->get_logger(), "stop old start new: the stop failed but the new task is started. stopping it.");
+            if (!stop_task_request())
+            {
+                RCLCPP_ERROR(this->get_logger(), "stop old start new: the new task cannot be stopped either!");
+            }
+        }
+        if (!isStopped || !isStarted)
+        {
+            RCLCPP_ERROR(this->get_logger(), "Issuing command: BAD NEWS FROM RESPONSE!");
+            return false;
+        }
+        return true;
+    }
+
     // void start_and_monitor(const nlohmann::json &skill_context)
     // {
     //     messenger_->start_and_monitor(skill_context);// ! change
@@ -260,6 +365,9 @@ private:
     }
 };
 
+#ifdef KIOS_COMPONENT
+RCLCPP_COMPONENTS_REGISTER_NODE(Commander)
+#else
 int main(int argc, char *argv[])
 {
     rclcpp::init(argc, argv);
@@ -270,8 +378,9 @@ int main(int argc, char *argv[])
 
     executor.spin();
 
-    // * unregister the udp before shutdown.
-    commander->shut_down_connection();
+    // * the connection is shut down in the destructor.
+    commander.reset();
     rclcpp::shutdown();
     return 0;
 }
+#endif
@@ -4,6 +4,7 @@
 #include <string>
 
 #include "rclcpp/rclcpp.hpp"
+#include "rclcpp_components/register_node_macro.hpp"
 
 #include "rcl_interfaces/msg/parameter.hpp"
 #include "rcl_interfaces/srv/get_parameters.hpp"
@@ -12,8 +13,13 @@
 #include "kios_interface/msg/mios_state.hpp"
 #include "kios_interface/msg/sensor_state.hpp"
 #include "kios_interface/msg/task_state.hpp"
+#include "kios_interface/msg/mios_state_fixed.hpp"
+#include "kios_interface/msg/sensor_state_fixed.hpp"
+#include "kios_interface/msg/task_state_fixed.hpp"
 
 #include "kios_utils/kios_utils.hpp"
+#include "kios_communication/boost_udp.hpp"
+#include "kios_communication/telemetry_decoder.hpp"
 
 #include <chrono>
 #include <condition_variable>
@@ -26,8 +32,8 @@ using std::placeholders::_1;
 class Messenger : public rclcpp::Node
 {
 public:
-    Messenger()
-        : Node("messenger")
+    explicit Messenger(const rclcpp::NodeOptions &options = rclcpp::NodeOptions())
+        : Node("messenger", options)
 
     {
         // * set ros2 logger severity level
@@ -35,6 +41,20 @@ public:
         rcutils_logging_set_logger_level(logger.get_name(), RCUTILS_LOG_SEVERITY_WARN);
 
         this->declare_parameter("power", true);
+        // * use the fixed-size state messages (loanable, no heap allocation per message)
+        this->declare_parameter("fixed_size_state", false);
+        isFixedSizeState_ = this->get_parameter("fixed_size_state").as_bool();
+        // * wrench samples kept between the publishes, and the window aggregated into each task state
+        this->declare_parameter("telemetry_history_depth", 256);
+        this->declare_parameter("telemetry_window_ms", 100);
+        telemetry_history_ = kios::TelemetryHistory(this->get_parameter("telemetry_history_depth").as_int());
+        // * the only reader of the mios udp telemetry (registered by the commander), every sample goes into the history
+        // * and the tree gets it with the task state.
+        // * without it the history only gets the one sample per publish of mios_reader.
+        // ! the port must not be used by mios_reader at the same time.
+        this->declare_parameter("direct_telemetry", false);
+        this->declare_parameter("telemetry_port", 12346);
+        isDirectTelemetry_ = this->get_parameter("direct_telemetry").as_bool();
 
         timer_callback_group_ = this->create_callback_group(
             rclcpp::CallbackGroupType::MutuallyExclusive);
@@ -54,25 +74,63 @@ public:
         publisher_options.callback_group = publisher_callback_group_;
 
         //* initialize the pub sub callbacks
-        mios_state_subscription_ = this->create_subscription<kios_interface::msg::MiosState>(
-            "mios_state_topic",
-            qos,
-            std::bind(&Messenger::mios_state_subscription_callback, this, _1),
-            subscription_options);
-        sensor_state_subscription_ = this->create_subscription<kios_interface::msg::SensorState>(
-            "sensor_state_topic",
-            qos,
-            std::bind(&Messenger::sensor_state_subscription_callback, this, _1),
-            subscription_options);
-
-        task_state_publisher_ = this->create_publisher<kios_interface::msg::TaskState>(
-            "task_state_topic",
-            qos,
-            publisher_options);
+        if (isFixedSizeState_)
+        {
+            mios_state_fixed_subscription_ = this->create_subscription<kios_interface::msg::MiosStateFixed>(
+                "mios_state_fixed_topic",
+                qos,
+                std::bind(&Messenger::mios_state_fixed_subscription_callback, this, _1),
+                subscription_options);
+            sensor_state_fixed_subscription_ = this->create_subscription<kios_interface::msg::SensorStateFixed>(
+                "sensor_state_fixed_topic",
+                qos,
+                std::bind(&Messenger::sensor_state_fixed_subscription_callback, this, _1),
+                subscription_options);
+
+            task_state_fixed_publisher_ = this->create_publisher<kios_interface::msg::TaskStateFixed>(
+                "task_state_fixed_topic",
+                qos,
+                publisher_options);
+        }
+        else
+        {
+            mios_state_subscription_ = this->create_subscription<kios_interface::msg::MiosState>(
+                "mios_state_topic",
+                qos,
+                std::bind(&Messenger::mios_state_subscription_callback, this, _1),
+                subscription_options);
+            sensor_state_subscription_ = this->create_subscription<kios_interface::msg::SensorState>(
+                "sensor_state_topic",
+                qos,
+                std::bind(&Messenger::sensor_state_subscription_callback, this, _1),
+                subscription_options);
+
+            task_state_publisher_ = this->create_publisher<kios_interface::msg::TaskState>(
+                "task_state_topic",
+                qos,
+                publisher_options);
+        }
+
+        if (isDirectTelemetry_)
+        {
+            telemetry_socket_ = std::make_shared<kios::BTReceiver>(
+                "127.0.0.1", this->get_parameter("telemetry_port").as_int());
+            // * drain in the socket thread, the telemetry rate is much higher than the publish rate
+            telemetry_socket_->set_message_callback([this]()
+                                                    { receive_telemetry(); });
+        }
 
         rclcpp::sleep_for(std::chrono::seconds(3));
     }
 
+    ~Messenger()
+    {
+        if (telemetry_socket_)
+        {
+            telemetry_socket_->set_message_callback(nullptr);
+        }
+    }
+
     bool check_power()
     {
         return this->get_parameter("power").as_bool();
@@ -80,6 +138,18 @@ public:
 
 private:
     kios_interface::msg::TaskState task_state_msg_;
+    kios_interface::msg::TaskStateFixed task_state_fixed_msg_;
+    bool isFixedSizeState_;
+
+    // * every received wrench sample, aggregated at publish time
+    kios::TelemetryHistory telemetry_history_;
+    // * with direct telemetry the history is filled in the socket thread
+    std::mutex telemetry_mtx_;
+    bool isDirectTelemetry_;
+    std::shared_ptr<kios::BTReceiver> telemetry_socket_;
+    kios::MiosTelemetry mios_telemetry_;       // socket thread only
+    kios::MiosTelemetry last_mios_telemetry_;  // under telemetry_mtx_
+    bool hasMiosTelemetry_ = false;            // under telemetry_mtx_
 
     // callback group
     rclcpp::CallbackGroup::SharedPtr publisher_callback_group_;
@@ -92,11 +162,24 @@ private:
     rclcpp::Subscription<kios_interface::msg::MiosState>::SharedPtr mios_state_subscription_;
     rclcpp::Subscription<kios_interface::msg::SensorState>::SharedPtr sensor_state_subscription_;
 
+    // fixed-size version
+    rclcpp::Publisher<kios_interface::msg::TaskStateFixed>::SharedPtr task_state_fixed_publisher_;
+    rclcpp::Subscription<kios_interface::msg::MiosStateFixed>::SharedPtr mios_state_fixed_subscription_;
+    rclcpp::Subscription<kios_interface::msg::SensorStateFixed>::SharedPtr sensor_state_fixed_subscription_;
+
     void mios_state_subscription_callback(kios_interface::msg::MiosState::SharedPtr msg)
     {
         if (check_power() == true)
         {
             RCLCPP_DEBUG(this->get_logger(), "MIOS SUB hit.");
+            if (isDirectTelemetry_)
+            {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(telemetry_mtx_);
+                telemetry_history_.push(msg->tf_f_ext_k.data(), msg->tf_f_ext_k.size());
+            }
             task_state_msg_.mios_state = std::move(*msg);
         }
         else
@@ -117,12 +200,127 @@ private:
         }
     }
 
+    void mios_state_fixed_subscription_callback(kios_interface::msg::MiosStateFixed::SharedPtr msg)
+    {
+        if (check_power() == true)
+        {
+            RCLCPP_DEBUG(this->get_logger(), "MIOS SUB hit.");
+            if (isDirectTelemetry_)
+            {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(telemetry_mtx_);
+                telemetry_history_.push(msg->tf_f_ext_k.data(), msg->tf_f_ext_k.size());
+            }
+            task_state_fixed_msg_.mios_state = *msg;
+        }
+        else
+        {
+            RCLCPP_ERROR(this->get_logger(), "POWER OFF, SUBSCRIPTION PASS ...");
+        }
+    }
+    void sensor_state_fixed_subscription_callback(kios_interface::msg::SensorStateFixed::SharedPtr msg)
+    {
+        if (check_power() == true)
+        {
+            RCLCPP_INFO(this->get_logger(), "SENSOR SUB hit.");
+            task_state_fixed_msg_.sensor_state = *msg;
+        }
+        else
+        {
+            RCLCPP_ERROR(this->get_logger(), "POWER OFF, SUBSCRIPTION PASS ...");
+        }
+    }
+
+    /**
+     * @brief decode all the telemetry datagrams in the receiver ring in place, every wrench sample goes into the history.
+     * called in the socket thread of telemetry_socket_.
+     */
+    void receive_telemetry()
+    {
+        bool hasNewTelemetry = false;
+        std::lock_guard<std::mutex> lock(telemetry_mtx_);
+        while (telemetry_socket_->consume_message(
+            [this, &hasNewTelemetry](const char *data, std::size_t length)
+            {
+                if (!kios::decode_mios_telemetry(data, length, mios_telemetry_))
+                {
+                    return;
+                }
+                if (mios_telemetry_.has(kios::TELEMETRY_TF_F_EXT_K))
+                {
+                    telemetry_history_.push(mios_telemetry_.tf_f_ext_k.data(), mios_telemetry_.tf_f_ext_k.size());
+                }
+                hasNewTelemetry = true;
+            }))
+        {
+        }
+        if (hasNewTelemetry)
+        {
+            last_mios_telemetry_ = mios_telemetry_;
+            hasMiosTelemetry_ = true;
+        }
+    }
+
+    /**
+     * @brief the wrench window of the task state, and with direct telemetry the mios state from the last datagram.
+     */
+    kios_interface::msg::TelemetryWindow take_telemetry()
+    {
+        std::lock_guard<std::mutex> lock(telemetry_mtx_);
+        if (isDirectTelemetry_ && hasMiosTelemetry_)
+        {
+            const auto &tf_f_ext_k = last_mios_telemetry_.tf_f_ext_k;
+            const auto &t_t_ee = last_mios_telemetry_.t_t_ee;
+            if (isFixedSizeState_)
+            {
+                std::copy(tf_f_ext_k.begin(), tf_f_ext_k.end(), task_state_fixed_msg_.mios_state.tf_f_ext_k.begin());
+                std::copy(t_t_ee.begin(), t_t_ee.end(), task_state_fixed_msg_.mios_state.t_t_ee.begin());
+            }
+            else
+            {
+                task_state_msg_.mios_state.tf_f_ext_k.assign(tf_f_ext_k.begin(), tf_f_ext_k.end());
+                task_state_msg_.mios_state.t_t_ee.assign(t_t_ee.begin(), t_t_ee.end());
+            }
+        }
+        return kios::telemetry_window_to_ros2_msg(
+            telemetry_history_.aggregate(std::chrono::milliseconds(this->get_parameter("telemetry_window_ms").as_int())));
+    }
+
+    /**
+     * @brief publish the fixed-size task state in a message loaned from the middleware if it supports it
+     * (e.g. shared memory transport), otherwise as unique_ptr.
+     */
+    void publish_task_state_fixed()
+    {
+        if (task_state_fixed_publisher_->can_loan_messages())
+        {
+            auto loaned_msg = task_state_fixed_publisher_->borrow_loaned_message();
+            loaned_msg.get() = task_state_fixed_msg_;
+            task_state_fixed_publisher_->publish(std::move(loaned_msg));
+        }
+        else
+        {
+            task_state_fixed_publisher_->publish(std::make_unique<kios_interface::msg::TaskStateFixed>(task_state_fixed_msg_));
+        }
+    }
+
     void timer_callback()
     {
         if (check_power() == true)
         {
             RCLCPP_INFO(this->get_logger(), "Publishing task_state.");
-            task_state_publisher_->publish(task_state_msg_);
+            auto telemetry = take_telemetry();
+            if (isFixedSizeState_)
+            {
+                task_state_fixed_msg_.telemetry = telemetry;
+                publish_task_state_fixed();
+                return;
+            }
+            task_state_msg_.telemetry = telemetry;
+            // * unique_ptr: moved to the tree node without serialization when composed with intra-process comms
+            task_state_publisher_->publish(std::make_unique<kios_interface::msg::TaskState>(task_state_msg_));
         }
         else
         {
@@ -131,6 +329,9 @@ private:
     }
 };
 
+#ifdef KIOS_COMPONENT
+RCLCPP_COMPONENTS_REGISTER_NODE(Messenger)
+#else
 int main(int argc, char *argv[])
 {
     rclcpp::init(argc, argv);
@@ -143,4 +344,5 @@ int main(int argc, char *argv[])
 
     rclcpp::shutdown();
     return 0;
-}
\ No newline at end of file
+}
+#endif
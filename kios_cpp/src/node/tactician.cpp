@@ -7,6 +7,7 @@
 #include <iostream>
 
 #include "rclcpp/rclcpp.hpp"
+#include "rclcpp_components/register_node_macro.hpp"
 
 #include "nlohmann/json.hpp"
 
@@ -15,6 +16,8 @@
 #include "kios_interface/msg/task_state.hpp"
 #include "kios_interface/msg/tree_state.hpp"
 
+#include "std_msgs/msg/u_int64.hpp"
+
 #include "kios_interface/srv/archive_action_request.hpp"
 #include "kios_interface/srv/fetch_skill_parameter_request.hpp"
 
@@ -26,8 +29,8 @@ using std::placeholders::_2;
 class Tactician : public rclcpp::Node
 {
 public:
-    Tactician()
-        : Node("tactician"),
+    explicit Tactician(const rclcpp::NodeOptions &options = rclcpp::NodeOptions())
+        : Node("tactician", options),
           command_context_(),
           tree_state_(),
           task_state_(),
@@ -72,6 +75,16 @@ public:
         // * initialize context clerk
         context_clerk_.read_archive(); // bool value return is not useful here.
 
+        // * context version for the skill parameter cache of tree node. latched for late joiners.
+        // ! transient local is not supported by intra-process comms, always go through dds.
+        rclcpp::PublisherOptions context_version_options;
+        context_version_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Disable;
+        context_version_publisher_ = this->create_publisher<std_msgs::msg::UInt64>(
+            "context_version_topic",
+            rclcpp::QoS(1).reliable().transient_local(),
+            context_version_options);
+        publish_context_version();
+
         std::cout << "finish initialization" << std::endl;
 
         rclcpp::sleep_for(std::chrono::seconds(3));
@@ -98,6 +111,15 @@ private:
 
     rclcpp::Service<kios_interface::srv::ArchiveActionRequest>::SharedPtr archive_action_server_;
 
+    rclcpp::Publisher<std_msgs::msg::UInt64>::SharedPtr context_version_publisher_;
+
+    void publish_context_version()
+    {
+        std_msgs::msg::UInt64 msg;
+        msg.data = context_clerk_.get_context_version();
+        context_version_publisher_->publish(msg);
+    }
+
     // rclcpp::Subscription<kios_interface::msg::TaskState>::SharedPtr task_state_subscription_;
 
     rclcpp::Service<kios_interface::srv::FetchSkillParameterRequest>::SharedPtr fetch_skill_parameter_server_;
@@ -142,7 +164,15 @@ private:
         }
 
         // load skill parameters into response
-        response->skill_parameters_json = context.dump();
+        if (request->accept_binary)
+        {
+            response->skill_parameters_cbor = nlohmann::json::to_cbor(context);
+        }
+        else
+        {
+            response->skill_parameters_json = context.dump();
+        }
+        response->context_version = context_clerk_.get_context_version();
         RCLCPP_INFO(this->get_logger(), "fetch skill parameter request accepted.");
         response->is_accepted = true;
     }
@@ -175,11 +205,17 @@ private:
             }
         }
 
+        // * new archives change the context, tree node has to drop its cached parameters
+        publish_context_version();
+
         response->is_accepted = isAccepted;
         response->error_message = err_msg;
     }
 };
 
+#ifdef KIOS_COMPONENT
+RCLCPP_COMPONENTS_REGISTER_NODE(Tactician)
+#else
 int main(int argc, char *argv[])
 {
     rclcpp::init(argc, argv);
@@ -192,4 +228,5 @@ int main(int argc, char *argv[])
 
     rclcpp::shutdown();
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include "kios_communication/spsc_ring.hpp"
+
+namespace
+{
+    using Ring = kios::SpscRing<16, 4>;
+
+    bool push(Ring &ring, const std::string &message)
+    {
+        return ring.push(message.data(), message.size());
+    }
+
+    std::string front(Ring &ring)
+    {
+        const Ring::Slot *slot = ring.front();
+        return slot == nullptr ? std::string() : std::string(slot->data, slot->length);
+    }
+} // namespace
+
+TEST(SpscRing, FifoAcrossTheWrap)
+{
+    Ring ring;
+    std::string message;
+    // * many times around the ring, head and tail pass the capacity
+    for (int i = 0; i < 10 * static_cast<int>(Ring::capacity()); i++)
+    {
+        ASSERT_TRUE(push(ring, std::to_string(i)));
+        ASSERT_TRUE(push(ring, std::to_string(i + 1000)));
+        ASSERT_TRUE(ring.pop(message));
+        EXPECT_EQ(message, std::to_string(i));
+        ASSERT_TRUE(ring.pop(message));
+        EXPECT_EQ(message, std::to_string(i + 1000));
+    }
+    EXPECT_TRUE(ring.empty());
+    EXPECT_FALSE(ring.pop(message));
+    EXPECT_EQ(ring.get_overflow_count(), 0u);
+}
+
+TEST(SpscRing, DropNewestOverflow)
+{
+    Ring ring(kios::RingOverflowPolicy::DROP_NEWEST);
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(push(ring, std::to_string(i)));
+    }
+    EXPECT_FALSE(push(ring, "4"));
+    EXPECT_FALSE(push(ring, "5"));
+    EXPECT_EQ(ring.get_overflow_count(), 2u);
+    EXPECT_EQ(ring.size(), 4u);
+
+    // * the oldest messages are kept
+    std::string message;
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(ring.pop(message));
+        EXPECT_EQ(message, std::to_string(i));
+    }
+    EXPECT_TRUE(push(ring, "6"));
+}
+
+TEST(SpscRing, TruncatesLongMessages)
+{
+    Ring ring;
+    ASSERT_TRUE(push(ring, std::string(40, 'x')));
+    const Ring::Slot *slot = ring.front();
+    ASSERT_NE(slot, nullptr);
+    EXPECT_EQ(slot->length, Ring::slot_size() - 1);
+    EXPECT_EQ(slot->data[slot->length], '\0');
+}
+
+TEST(SpscRing, BatchedWrite)
+{
+    Ring ring;
+    for (std::size_t i = 0; i < 3; i++)
+    {
+        Ring::Slot *slot = ring.acquire_write_slot(i);
+        ASSERT_NE(slot, nullptr);
+        slot->length = 1;
+        slot->data[0] = static_cast<char>('a' + i);
+    }
+    // * nothing is visible before the commit
+    EXPECT_TRUE(ring.empty());
+    ring.commit_write(3);
+    EXPECT_EQ(ring.size(), 3u);
+    EXPECT_EQ(ring.acquire_write_slot(1), nullptr);
+    EXPECT_EQ(front(ring), "a");
+}
+
+TEST(SpscRing, LatestWinsKeepsTheNewest)
+{
+    Ring ring(kios::RingOverflowPolicy::LATEST_WINS);
+    for (int i = 0; i < 20; i++)
+    {
+        ASSERT_TRUE(push(ring, std::to_string(i)));
+    }
+    EXPECT_EQ(ring.get_overflow_count(), 0u);
+    EXPECT_EQ(front(ring), "19");
+    ring.pop();
+    EXPECT_EQ(ring.front(), nullptr);
+    // * every older message is counted once, by the producer or by the consumer
+    EXPECT_EQ(ring.get_overwritten_count(), 19u);
+}
+
+TEST(SpscRing, LatestWinsNeverReusesTheSlotBeingRead)
+{
+    Ring ring(kios::RingOverflowPolicy::LATEST_WINS);
+    ASSERT_TRUE(push(ring, "held"));
+    const Ring::Slot *held = ring.front();
+    ASSERT_NE(held, nullptr);
+
+    int stored = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        stored += push(ring, std::to_string(i)) ? 1 : 0;
+    }
+    EXPECT_EQ(std::string(held->data, held->length), "held");
+    EXPECT_EQ(stored + static_cast<int>(ring.get_overflow_count()), 10);
+    ring.pop();
+
+    // * once released the newest message is read
+    ASSERT_TRUE(push(ring, "newest"));
+    EXPECT_EQ(front(ring), "newest");
+    ring.pop();
+}
+
+TEST(SpscRing, LatestWinsBlockedArrivalDropsNothing)
+{
+    Ring ring(kios::RingOverflowPolicy::LATEST_WINS);
+    ASSERT_TRUE(push(ring, "held"));
+    ASSERT_NE(ring.front(), nullptr);
+    for (const char *message : {"a", "b", "c"})
+    {
+        ASSERT_TRUE(push(ring, message));
+    }
+
+    // * the next slot is the held one: the new message is lost, the queued ones are kept
+    EXPECT_FALSE(push(ring, "d"));
+    EXPECT_EQ(ring.get_overflow_count(), 1u);
+    EXPECT_EQ(ring.get_overwritten_count(), 0u);
+    EXPECT_EQ(ring.size(), 3u);
+    ring.pop();
+    EXPECT_EQ(front(ring), "c");
+    ring.pop();
+}
+
+TEST(SpscRing, LatestWinsConcurrent)
+{
+    kios::SpscRing<32, 8> ring(kios::RingOverflowPolicy::LATEST_WINS);
+    constexpr int kCount = 100000;
+    std::thread producer([&ring]()
+                         {
+        for (int i = 0; i < kCount; i++)
+        {
+            const std::string message = std::to_string(i);
+            ring.push(message.data(), message.size());
+        } });
+
+    // * the consumer sees increasing, untorn messages
+    long last = -1;
+    while (last < kCount - 1)
+    {
+        const auto *slot = ring.front();
+        if (slot == nullptr)
+        {
+            if (ring.get_pushed_count() + ring.get_overflow_count() == kCount && ring.empty())
+            {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        const long value = std::stol(std::string(slot->data, slot->length));
+        EXPECT_GT(value, last);
+        last = value;
+        ring.pop();
+    }
+    producer.join();
+    EXPECT_GE(last, 0);
+}
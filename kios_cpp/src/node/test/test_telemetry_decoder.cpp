@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+#include "kios_communication/telemetry_decoder.hpp"
+
+namespace
+{
+    bool decode(const std::string &datagram, kios::MiosTelemetry &telemetry)
+    {
+        // * std::string is '\0' terminated at size(), as the slots of BTReceiver are
+        return kios::decode_mios_telemetry(datagram.c_str(), datagram.size(), telemetry);
+    }
+
+    const std::string kDatagram =
+        R"({"result": {"TF_F_ext_K": [1, 2, 3.5, -4, 5e-1, 6],)"
+        R"( "T_T_EE": [1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.1, 0.2, 0.3, 1],)"
+        R"( "tau_ext": [0, 1, 2, 3, 4, 5, 6], "q": [7, 6, 5, 4, 3, 2, 1], "system_time": 12.25}})";
+} // namespace
+
+TEST(TelemetryDecoder, DecodesAllFields)
+{
+    kios::MiosTelemetry telemetry;
+    ASSERT_TRUE(decode(kDatagram, telemetry));
+    EXPECT_TRUE(telemetry.has(kios::TELEMETRY_TF_F_EXT_K));
+    EXPECT_TRUE(telemetry.has(kios::TELEMETRY_T_T_EE));
+    EXPECT_TRUE(telemetry.has(kios::TELEMETRY_TAU_EXT));
+    EXPECT_TRUE(telemetry.has(kios::TELEMETRY_Q));
+    EXPECT_TRUE(telemetry.has(kios::TELEMETRY_SYSTEM_TIME));
+    EXPECT_DOUBLE_EQ(telemetry.tf_f_ext_k[2], 3.5);
+    EXPECT_DOUBLE_EQ(telemetry.tf_f_ext_k[4], 0.5);
+    EXPECT_DOUBLE_EQ(telemetry.t_t_ee[14], 0.3);
+    EXPECT_DOUBLE_EQ(telemetry.tau_ext[6], 6);
+    EXPECT_DOUBLE_EQ(telemetry.q[0], 7);
+    EXPECT_DOUBLE_EQ(telemetry.system_time, 12.25);
+}
+
+TEST(TelemetryDecoder, KeyOrderDoesNotMatter)
+{
+    const std::string reordered =
+        R"({"system_time": 3, "unknown": {"nested": [1, 2]}, "q": [1, 1, 1, 1, 1, 1, 1],)"
+        R"( "TF_F_ext_K": [6, 5, 4, 3, 2, 1]})";
+    kios::MiosTelemetry telemetry;
+    ASSERT_TRUE(decode(reordered, telemetry));
+    EXPECT_TRUE(telemetry.has(kios::TELEMETRY_TF_F_EXT_K));
+    EXPECT_TRUE(telemetry.has(kios::TELEMETRY_Q));
+    EXPECT_TRUE(telemetry.has(kios::TELEMETRY_SYSTEM_TIME));
+    EXPECT_FALSE(telemetry.has(kios::TELEMETRY_T_T_EE));
+    EXPECT_DOUBLE_EQ(telemetry.tf_f_ext_k[0], 6);
+    EXPECT_DOUBLE_EQ(telemetry.system_time, 3);
+}
+
+TEST(TelemetryDecoder, WrongSizeArrayKeepsTheField)
+{
+    kios::MiosTelemetry telemetry;
+    ASSERT_TRUE(decode(kDatagram, telemetry));
+
+    // * 5 and 7 elements instead of 6
+    EXPECT_FALSE(decode(R"({"TF_F_ext_K": [9, 9, 9, 9, 9]})", telemetry));
+    EXPECT_FALSE(decode(R"({"TF_F_ext_K": [9, 9, 9, 9, 9, 9, 9]})", telemetry));
+    EXPECT_FALSE(telemetry.has(kios::TELEMETRY_TF_F_EXT_K));
+    EXPECT_DOUBLE_EQ(telemetry.tf_f_ext_k[0], 1);
+    EXPECT_DOUBLE_EQ(telemetry.tf_f_ext_k[5], 6);
+}
+
+TEST(TelemetryDecoder, MalformedValues)
+{
+    kios::MiosTelemetry telemetry;
+    EXPECT_FALSE(decode(R"({"TF_F_ext_K": "1, 2, 3, 4, 5, 6"})", telemetry));
+    EXPECT_FALSE(decode(R"({"TF_F_ext_K": [1, 2, x, 4, 5, 6]})", telemetry));
+    EXPECT_FALSE(decode(R"({"system_time": null})", telemetry));
+    EXPECT_FALSE(decode("not json at all", telemetry));
+    EXPECT_FALSE(decode("", telemetry));
+    EXPECT_EQ(telemetry.field_mask, 0u);
+
+    // * a bad field does not stop the good ones
+    ASSERT_TRUE(decode(R"({"TF_F_ext_K": [1, 2], "system_time": 4})", telemetry));
+    EXPECT_FALSE(telemetry.has(kios::TELEMETRY_TF_F_EXT_K));
+    EXPECT_TRUE(telemetry.has(kios::TELEMETRY_SYSTEM_TIME));
+}
+
+TEST(TelemetryDecoder, TruncatedDatagram)
+{
+    // * cut everywhere in the datagram, the decoder must never read past length
+    for (std::size_t length = 0; length < kDatagram.size(); length++)
+    {
+        const std::string truncated = kDatagram.substr(0, length);
+        kios::MiosTelemetry telemetry;
+        decode(truncated, telemetry);
+        if (truncated.find("\"T_T_EE\"") == std::string::npos)
+        {
+            EXPECT_FALSE(telemetry.has(kios::TELEMETRY_T_T_EE)) << "length " << length;
+        }
+    }
+
+    kios::MiosTelemetry telemetry;
+    const std::string cut_in_array = kDatagram.substr(0, kDatagram.find("3.5"));
+    EXPECT_FALSE(decode(cut_in_array, telemetry));
+    EXPECT_FALSE(telemetry.has(kios::TELEMETRY_TF_F_EXT_K));
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+
+#include "kios_utils/telemetry_history.hpp"
+
+namespace
+{
+    using Clock = kios::TelemetryHistory::Clock;
+    using std::chrono::milliseconds;
+
+    std::array<double, 6> wrench(double fz)
+    {
+        return {0, 0, fz, 0, 0, 0};
+    }
+} // namespace
+
+TEST(TelemetryHistory, EmptyWindow)
+{
+    kios::TelemetryHistory history(8);
+    const auto window = history.aggregate(milliseconds(100));
+    EXPECT_EQ(window.sample_count, 0u);
+    EXPECT_DOUBLE_EQ(window.f_ext_max_norm, 0);
+}
+
+TEST(TelemetryHistory, AggregatesTheWindow)
+{
+    kios::TelemetryHistory history(8);
+    const auto now = Clock::now();
+    history.push(wrench(-9).data(), 6, now - milliseconds(30));
+    history.push(wrench(3).data(), 6, now - milliseconds(20));
+    history.push(wrench(1).data(), 6, now - milliseconds(10));
+
+    const auto window = history.aggregate(milliseconds(100), now);
+    EXPECT_EQ(window.sample_count, 3u);
+    // * the spike between the publishes is in the peak
+    EXPECT_DOUBLE_EQ(window.tf_f_ext_k_max_abs[2], 9);
+    EXPECT_DOUBLE_EQ(window.f_ext_max_norm, 9);
+    EXPECT_DOUBLE_EQ(window.tf_f_ext_k_mean[2], (-9 + 3 + 1) / 3.0);
+    EXPECT_DOUBLE_EQ(window.tf_f_ext_k_last[2], 1);
+    EXPECT_NEAR(window.window_duration, 0.02, 1e-9);
+}
+
+TEST(TelemetryHistory, OlderSamplesAreOutsideTheWindow)
+{
+    kios::TelemetryHistory history(8);
+    const auto now = Clock::now();
+    history.push(wrench(50).data(), 6, now - milliseconds(500));
+    history.push(wrench(2).data(), 6, now - milliseconds(10));
+
+    auto window = history.aggregate(milliseconds(100), now);
+    EXPECT_EQ(window.sample_count, 1u);
+    EXPECT_DOUBLE_EQ(window.tf_f_ext_k_max_abs[2], 2);
+
+    // * the last value is the newest sample, also outside the window
+    window = history.aggregate(milliseconds(1), now + milliseconds(100));
+    EXPECT_EQ(window.sample_count, 0u);
+    EXPECT_DOUBLE_EQ(window.tf_f_ext_k_last[2], 2);
+}
+
+TEST(TelemetryHistory, OverwritesTheOldest)
+{
+    kios::TelemetryHistory history(4);
+    const auto now = Clock::now();
+    for (int i = 0; i < 10; i++)
+    {
+        history.push(wrench(100 - i).data(), 6, now - milliseconds(10 - i));
+    }
+    EXPECT_EQ(history.size(), 4u);
+    EXPECT_EQ(history.get_pushed_count(), 10u);
+
+    const auto window = history.aggregate(milliseconds(1000), now);
+    EXPECT_EQ(window.sample_count, 4u);
+    EXPECT_DOUBLE_EQ(window.tf_f_ext_k_max_abs[2], 94);
+    EXPECT_DOUBLE_EQ(window.tf_f_ext_k_last[2], 91);
+}
+
+TEST(TelemetryHistory, ShortSamplesAreZeroFilled)
+{
+    kios::TelemetryHistory history(4);
+    const double partial[2] = {3, 4};
+    history.push(partial, 2);
+    const auto window = history.aggregate(milliseconds(100));
+    EXPECT_EQ(window.sample_count, 1u);
+    EXPECT_DOUBLE_EQ(window.f_ext_max_norm, 5);
+    EXPECT_DOUBLE_EQ(window.tf_f_ext_k_last[5], 0);
+
+    history.clear();
+    EXPECT_EQ(history.size(), 0u);
+    EXPECT_EQ(history.aggregate(milliseconds(100)).sample_count, 0u);
+}
+
+TEST(TelemetryHistory, MergeKeepsThePeaks)
+{
+    kios::TelemetryHistory history(8);
+    const auto now = Clock::now();
+    history.push(wrench(-8).data(), 6, now - milliseconds(150));
+    history.push(wrench(2).data(), 6, now - milliseconds(120));
+    const auto older = history.aggregate(milliseconds(100), now - milliseconds(100));
+    history.push(wrench(4).data(), 6, now - milliseconds(10));
+    const auto newer = history.aggregate(milliseconds(100), now);
+
+    const auto merged = kios::merge_telemetry_windows(older, newer);
+    EXPECT_EQ(merged.sample_count, 3u);
+    EXPECT_DOUBLE_EQ(merged.tf_f_ext_k_max_abs[2], 8);
+    EXPECT_DOUBLE_EQ(merged.f_ext_max_norm, 8);
+    EXPECT_DOUBLE_EQ(merged.tf_f_ext_k_mean[2], (-8 + 2 + 4) / 3.0);
+    EXPECT_DOUBLE_EQ(merged.tf_f_ext_k_last[2], 4);
+
+    // * an empty window only brings its last value
+    kios::TelemetryWindow empty;
+    empty.tf_f_ext_k_last[2] = 5;
+    const auto with_empty = kios::merge_telemetry_windows(older, empty);
+    EXPECT_EQ(with_empty.sample_count, older.sample_count);
+    EXPECT_DOUBLE_EQ(with_empty.tf_f_ext_k_max_abs[2], 8);
+    EXPECT_DOUBLE_EQ(with_empty.tf_f_ext_k_last[2], 5);
+    EXPECT_EQ(kios::merge_telemetry_windows(empty, newer).sample_count, newer.sample_count);
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "behavior_tree/tree_blueprint.hpp"
+
+namespace
+{
+    std::string make_tree(const std::string &name)
+    {
+        return R"(<root BTCPP_format="4" main_tree_to_execute="MainTree">
+    <BehaviorTree ID="MainTree">
+        <Sequence name=")" +
+               name + R"(">
+            <AlwaysSuccess/>
+            <AlwaysSuccess/>
+        </Sequence>
+    </BehaviorTree>
+</root>)";
+    }
+} // namespace
+
+TEST(TreeBlueprintCache, ParsesOnce)
+{
+    BT::BehaviorTreeFactory factory;
+    Insertion::TreeBlueprintCache cache;
+    const std::string tree = make_tree("a");
+
+    auto first = cache.get_blueprint(factory, tree);
+    auto second = cache.get_blueprint(factory, tree);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(cache.get_miss_count(), 1u);
+    EXPECT_EQ(cache.get_hit_count(), 1u);
+    EXPECT_EQ(cache.size(), 1u);
+
+    // * a different text is a different blueprint
+    auto other = cache.get_blueprint(factory, make_tree("b"));
+    EXPECT_NE(first, other);
+    EXPECT_EQ(cache.get_miss_count(), 2u);
+}
+
+TEST(TreeBlueprintCache, InstantiatesAndRecordsTheManifest)
+{
+    BT::BehaviorTreeFactory factory;
+    Insertion::TreeBlueprintCache cache;
+    auto blueprint = cache.get_blueprint(factory, make_tree("a"));
+    EXPECT_FALSE(blueprint->hasManifest);
+
+    BT::Tree tree = cache.instantiate(*blueprint);
+    EXPECT_TRUE(blueprint->hasManifest);
+    EXPECT_EQ(blueprint->nodes.size(), 3u);
+    EXPECT_EQ(blueprint->manifests.count("AlwaysSuccess"), 1u);
+    EXPECT_EQ(tree.tickWhileRunning(), BT::NodeStatus::SUCCESS);
+
+    // * every instantiation is a new tree
+    BT::Tree again = cache.instantiate(*blueprint);
+    EXPECT_NE(tree.rootNode(), again.rootNode());
+    EXPECT_EQ(again.tickWhileRunning(), BT::NodeStatus::SUCCESS);
+}
+
+TEST(TreeBlueprintCache, InvalidXmlIsNotCached)
+{
+    BT::BehaviorTreeFactory factory;
+    Insertion::TreeBlueprintCache cache;
+    const std::string unknown_node = R"(<root BTCPP_format="4" main_tree_to_execute="MainTree">
+    <BehaviorTree ID="MainTree">
+        <NoSuchNode/>
+    </BehaviorTree>
+</root>)";
+    EXPECT_ANY_THROW(cache.get_blueprint(factory, unknown_node));
+    EXPECT_ANY_THROW(cache.get_blueprint(factory, "<root"));
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(TreeBlueprintCache, EvictsTheLeastRecentlyUsed)
+{
+    BT::BehaviorTreeFactory factory;
+    Insertion::TreeBlueprintCache cache(2);
+    auto a = cache.get_blueprint(factory, make_tree("a"));
+    cache.get_blueprint(factory, make_tree("b"));
+    // * a is used again, b is the oldest now
+    cache.get_blueprint(factory, make_tree("a"));
+    cache.get_blueprint(factory, make_tree("c"));
+    EXPECT_EQ(cache.size(), 2u);
+
+    const auto misses = cache.get_miss_count();
+    EXPECT_EQ(cache.get_blueprint(factory, make_tree("a")), a);
+    EXPECT_EQ(cache.get_miss_count(), misses);
+    cache.get_blueprint(factory, make_tree("b"));
+    EXPECT_EQ(cache.get_miss_count(), misses + 1);
+
+    // * an evicted blueprint still builds trees
+    EXPECT_EQ(cache.instantiate(*a).tickWhileRunning(), BT::NodeStatus::SUCCESS);
+
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0u);
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "behavior_tree/tree_root.hpp"
+
+namespace
+{
+    std::string make_tree(const std::string &actions)
+    {
+        return R"(<root BTCPP_format="4" main_tree_to_execute="MainTree">
+    <BehaviorTree ID="MainTree">
+        <Sequence>
+)" + actions + R"(
+        </Sequence>
+    </BehaviorTree>
+</root>)";
+    }
+
+    const std::string kMoveA = R"(<JointMove name="a" action_id="1" objects="x"/>)";
+    const std::string kMoveB = R"(<JointMove name="b" action_id="2" objects="y"/>)";
+    const std::string kMoveC = R"(<CartesianMove name="c" action_id="3" objects="z"/>)";
+
+    class TreeUpdateTest : public ::testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            tree_state_ptr_ = std::make_shared<kios::TreeState>();
+            task_state_ptr_ = std::make_shared<kios::TaskState>();
+            tree_root_ = std::make_unique<Insertion::TreeRoot>(tree_state_ptr_, task_state_ptr_);
+            ASSERT_TRUE(tree_root_->register_nodes());
+            ASSERT_TRUE(tree_root_->construct_tree(make_tree(kMoveA + kMoveB + kMoveC)));
+            ASSERT_TRUE(tree_root_->archive_nodes().has_value());
+
+            // * mios reports the first action done, it latches its success
+            task_state_ptr_->isActionSuccess = true;
+            ASSERT_EQ(tree_root_->tick_once(), BT::NodeStatus::RUNNING);
+            ASSERT_EQ(tree_root_->get_tree_statistics().succeeded_count, 1u);
+        }
+
+        std::shared_ptr<kios::TreeState> tree_state_ptr_;
+        std::shared_ptr<kios::TaskState> task_state_ptr_;
+        std::unique_ptr<Insertion::TreeRoot> tree_root_;
+    };
+} // namespace
+
+TEST_F(TreeUpdateTest, InsertedNodeKeepsTheOthersLatches)
+{
+    const std::string inserted = R"(<GripperMove name="new" action_id="9" objects="w"/>)";
+    auto update = tree_root_->update_tree(make_tree(inserted + kMoveA + kMoveB + kMoveC));
+    ASSERT_TRUE(update.has_value());
+    EXPECT_EQ(update->kept_count, 3u);
+    EXPECT_EQ(update->removed_count, 0u);
+    ASSERT_EQ(update->changed_archives.size(), 1u);
+    EXPECT_EQ(update->changed_archives[0].action_id, 9);
+
+    auto statistics = tree_root_->get_tree_statistics();
+    EXPECT_EQ(statistics.action_node_count, 4u);
+    EXPECT_EQ(statistics.succeeded_count, 1u);
+}
+
+TEST_F(TreeUpdateTest, MovedNodeKeepsItsLatch)
+{
+    auto update = tree_root_->update_tree(make_tree(kMoveB + kMoveC + kMoveA));
+    ASSERT_TRUE(update.has_value());
+    EXPECT_EQ(update->kept_count, 3u);
+    EXPECT_TRUE(update->changed_archives.empty());
+    EXPECT_EQ(tree_root_->get_tree_statistics().succeeded_count, 1u);
+}
+
+TEST_F(TreeUpdateTest, ChangedPortIsArchivedAgain)
+{
+    const std::string changed = R"(<CartesianMove name="c" action_id="4" objects="z"/>)";
+    auto update = tree_root_->update_tree(make_tree(kMoveA + kMoveB + changed));
+    ASSERT_TRUE(update.has_value());
+    EXPECT_EQ(update->kept_count, 2u);
+    EXPECT_EQ(update->removed_count, 1u);
+    ASSERT_EQ(update->changed_archives.size(), 1u);
+    EXPECT_EQ(update->changed_archives[0].action_id, 4);
+
+    // * the archive of the changed node is the one of the tree now
+    auto archives = tree_root_->archive_nodes();
+    ASSERT_TRUE(archives.has_value());
+    ASSERT_EQ(archives->size(), 3u);
+    EXPECT_EQ((*archives)[2].action_id, 4);
+    EXPECT_EQ(tree_root_->get_tree_statistics().succeeded_count, 1u);
+}
+
+TEST_F(TreeUpdateTest, InvalidTreeKeepsTheOldTreeRunning)
+{
+    auto blueprint = tree_root_->get_blueprint();
+    auto update = tree_root_->update_tree(make_tree(R"(<NotANode/>)"));
+    EXPECT_FALSE(update.has_value());
+    EXPECT_EQ(tree_root_->get_blueprint(), blueprint);
+
+    auto statistics = tree_root_->get_tree_statistics();
+    EXPECT_EQ(statistics.action_node_count, 3u);
+    EXPECT_EQ(statistics.succeeded_count, 1u);
+
+    // * the old tree goes on from where it was: the second action is done now
+    task_state_ptr_->isActionSuccess = true;
+    EXPECT_EQ(tree_root_->tick_once(), BT::NodeStatus::RUNNING);
+    EXPECT_EQ(tree_root_->get_tree_statistics().succeeded_count, 2u);
+}
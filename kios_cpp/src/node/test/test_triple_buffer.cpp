@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+
+#include "kios_utils/triple_buffer.hpp"
+
+namespace
+{
+    struct State
+    {
+        std::uint64_t sequence = 0;
+        std::uint64_t twice = 0;
+    };
+} // namespace
+
+TEST(TripleBuffer, NothingBeforeThePublish)
+{
+    kios::TripleBuffer<State> buffer;
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(buffer.read().sequence, 0u);
+    EXPECT_EQ(buffer.get_published_count(), 0u);
+}
+
+TEST(TripleBuffer, HandsOverThePublishedState)
+{
+    kios::TripleBuffer<State> buffer;
+    buffer.write_buffer().sequence = 1;
+    buffer.publish();
+    ASSERT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.read().sequence, 1u);
+    // * taken once
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(buffer.read().sequence, 1u);
+}
+
+TEST(TripleBuffer, LatestWins)
+{
+    kios::TripleBuffer<State> buffer;
+    for (std::uint64_t i = 1; i <= 5; i++)
+    {
+        buffer.write_buffer().sequence = i;
+        buffer.publish();
+    }
+    ASSERT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.read().sequence, 5u);
+    EXPECT_EQ(buffer.get_published_count(), 5u);
+}
+
+TEST(TripleBuffer, HasUnread)
+{
+    kios::TripleBuffer<State> buffer;
+    EXPECT_FALSE(buffer.has_unread());
+    buffer.publish();
+    EXPECT_TRUE(buffer.has_unread());
+    buffer.publish();
+    EXPECT_TRUE(buffer.has_unread());
+    ASSERT_TRUE(buffer.update());
+    EXPECT_FALSE(buffer.has_unread());
+}
+
+TEST(TripleBuffer, ReadIsStableWhileTheProducerWrites)
+{
+    kios::TripleBuffer<State> buffer;
+    buffer.write_buffer().sequence = 1;
+    buffer.publish();
+    ASSERT_TRUE(buffer.update());
+    const State &front = buffer.read();
+
+    for (std::uint64_t i = 2; i < 10; i++)
+    {
+        buffer.write_buffer().sequence = i;
+        buffer.publish();
+    }
+    EXPECT_EQ(front.sequence, 1u);
+}
+
+TEST(TripleBuffer, BackBufferIsNotCleared)
+{
+    kios::TripleBuffer<State> buffer;
+    buffer.write_buffer().sequence = 1;
+    buffer.publish();
+    buffer.write_buffer().sequence = 2;
+    buffer.publish();
+    // * the producer got the buffer of the first publish back, nobody took it
+    EXPECT_EQ(buffer.write_buffer().sequence, 1u);
+}
+
+TEST(TripleBuffer, Concurrent)
+{
+    kios::TripleBuffer<State> buffer;
+    constexpr std::uint64_t kCount = 200000;
+    std::thread producer([&buffer]()
+                         {
+        for (std::uint64_t i = 1; i <= kCount; i++)
+        {
+            State &state = buffer.write_buffer();
+            state.sequence = i;
+            state.twice = 2 * i;
+            buffer.publish();
+        } });
+
+    std::uint64_t last = 0;
+    while (last < kCount)
+    {
+        if (!buffer.update())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const State &state = buffer.read();
+        ASSERT_EQ(state.twice, 2 * state.sequence);
+        ASSERT_GT(state.sequence, last);
+        last = state.sequence;
+    }
+    producer.join();
+}
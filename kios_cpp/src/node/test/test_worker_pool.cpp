@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "kios_utils/worker_pool.hpp"
+
+TEST(WorkerPool, RunsEveryIndexOnce)
+{
+    kios::WorkerPool pool(3);
+    std::vector<std::atomic<int>> calls(1000);
+    pool.parallel_for(calls.size(), [&calls](std::size_t i)
+                      { calls[i]++; }, 4);
+    for (const auto &call : calls)
+    {
+        EXPECT_EQ(call.load(), 1);
+    }
+}
+
+TEST(WorkerPool, NoWorkers)
+{
+    kios::WorkerPool pool(0);
+    EXPECT_EQ(pool.get_worker_count(), 0u);
+    std::size_t sum = 0;
+    pool.parallel_for(100, [&sum](std::size_t i)
+                      { sum += i; }, 1);
+    EXPECT_EQ(sum, 4950u);
+}
+
+TEST(WorkerPool, RethrowsTheLowestIndex)
+{
+    kios::WorkerPool pool(3);
+    std::atomic<std::size_t> count{0};
+    try
+    {
+        pool.parallel_for(
+            500, [&count](std::size_t i)
+            {
+                count++;
+                if (i % 100 == 37)
+                {
+                    throw std::runtime_error(std::to_string(i));
+                } },
+            4);
+        FAIL() << "no exception";
+    }
+    catch (const std::runtime_error &e)
+    {
+        EXPECT_EQ(std::string(e.what()), "37");
+    }
+    // * the other indices still ran
+    EXPECT_EQ(count.load(), 500u);
+}
+
+TEST(WorkerPool, UsableAfterAnException)
+{
+    kios::WorkerPool pool(2);
+    EXPECT_THROW(pool.parallel_for(
+                     64, [](std::size_t i)
+                     {
+                         if (i == 63)
+                         {
+                             throw std::logic_error("last");
+                         } },
+                     1),
+                 std::logic_error);
+
+    std::atomic<std::size_t> count{0};
+    EXPECT_NO_THROW(pool.parallel_for(64, [&count](std::size_t)
+                                      { count++; }, 1));
+    EXPECT_EQ(count.load(), 64u);
+}
@@ -7,18 +7,26 @@
 #include <optional>
 #include <mutex>
 #include <thread>
+#include <atomic>
 
 #include "kios_utils/data_type.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_action/rclcpp_action.hpp"
+#include "rclcpp_components/register_node_macro.hpp"
 #include "rcl_interfaces/msg/parameter.hpp"
 
 #include "behavior_tree/tree_root.hpp"
 #include "kios_utils/kios_utils.hpp"
+#include "kios_utils/tick_scheduler.hpp"
+#include "kios_utils/triple_buffer.hpp"
+#include "kios_utils/skill_parameter_cache.hpp"
 #include "kios_communication/boost_udp.hpp"
 
 #include "kios_interface/msg/tree_state.hpp"
 #include "kios_interface/msg/task_state.hpp"
+#include "kios_interface/msg/task_state_fixed.hpp"
+
+#include "std_msgs/msg/u_int64.hpp"
 
 #include "kios_interface/srv/get_object_request.hpp"
 #include "kios_interface/srv/switch_tree_phase_request.hpp"
@@ -54,6 +62,16 @@ public:
 
         //* declare mission parameter
         this->declare_parameter("power", true);
+        // * upper bound of the tick period. the tree is ticked earlier whenever an event arrives.
+        this->declare_parameter("max_tick_period_ms", 100);
+        // * fetch the skill parameter as cbor and forward it to the commander without decoding
+        this->declare_parameter("binary_skill_parameter", true);
+        // * reuse the fetched skill parameters until the tactician changes its context
+        this->declare_parameter("skill_parameter_cache", true);
+        // * fetch the parameters of all action nodes right after the archives are loaded
+        this->declare_parameter("prefetch_skill_parameters", false);
+        // * subscribe the fixed-size task state of the messenger
+        this->declare_parameter("fixed_size_state", false);
 
         //* initialize the callback groups
         timer_callback_group_ = this->create_callback_group(
@@ -75,11 +93,32 @@ public:
         subscription_options.callback_group = subscription_callback_group_;
 
         // * initialize the callbacks
-        subscription_ = this->create_subscription<kios_interface::msg::TaskState>(
-            "task_state_topic",
-            qos,
-            std::bind(&TreeNode::subscription_callback, this, _1),
-            subscription_options);
+        if (this->get_parameter("fixed_size_state").as_bool())
+        {
+            fixed_subscription_ = this->create_subscription<kios_interface::msg::TaskStateFixed>(
+                "task_state_fixed_topic",
+                qos,
+                std::bind(&TreeNode::fixed_subscription_callback, this, _1),
+                subscription_options);
+        }
+        else
+        {
+            subscription_ = this->create_subscription<kios_interface::msg::TaskState>(
+                "task_state_topic",
+                qos,
+                std::bind(&TreeNode::subscription_callback, this, _1),
+                subscription_options);
+        }
+
+        rclcpp::SubscriptionOptions client_subscription_options;
+        client_subscription_options.callback_group = client_callback_group_;
+        // ! transient local is not supported by intra-process comms
+        client_subscription_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Disable;
+        context_version_subscription_ = this->create_subscription<std_msgs::msg::UInt64>(
+            "context_version_topic",
+            rclcpp::QoS(1).reliable().transient_local(),
+            std::bind(&TreeNode::context_version_callback, this, _1),
+            client_subscription_options);
 
         archive_action_client_ = this->create_client<kios_interface::srv::ArchiveActionRequest>(
             "archive_action_service",
@@ -116,12 +155,28 @@ public:
             std::bind(&TreeNode::execute_tree_handle_cancel, this, _1),
             std::bind(&TreeNode::execute_tree_handle_accepted, this, _1));
 
+        // * initialize the tick scheduler. replaces the fixed wall timer.
+        tick_scheduler_ = std::make_unique<kios::TickScheduler>(
+            std::bind(&TreeNode::timer_callback, this),
+            std::chrono::milliseconds(this->get_parameter("max_tick_period_ms").as_int()));
+
         udp_socket_ = std::make_shared<kios::BTReceiver>("127.0.0.1", 8888);
+        // * wake up the tree as soon as a mios phase message arrives
+        udp_socket_->set_message_callback([this]() { tick_scheduler_->notify(); });
 
         // * set tree phase to resume to let tree tick
         tree_phase_ = kios::TreePhase::RESUME;
 
         rclcpp::sleep_for(std::chrono::seconds(4));
+
+        tick_scheduler_->start();
+    }
+
+    ~TreeNode()
+    {
+        // * stop the event sources first, then the tick thread
+        udp_socket_->set_message_callback(nullptr);
+        tick_scheduler_->stop();
     }
 
     bool check_power()
@@ -156,11 +211,34 @@ private:
     std::mutex tree_mtx_;
     std::mutex tree_phase_mtx_;
 
-    nlohmann::json skill_parameter_;
+    // * the skill parameter is only forwarded from tactician to commander, it is not decoded here.
+    // * cbor if the tactician sent it binary, otherwise json text.
+    std::vector<uint8_t> skill_parameter_cbor_;
+    std::string skill_parameter_json_ = "null";
+
+    // * skill parameter cache rel
+    kios::SkillParameterCache skill_parameter_cache_;
+    std::atomic<std::uint64_t> context_version_{0};
+    rclcpp::Subscription<std_msgs::msg::UInt64>::SharedPtr context_version_subscription_;
 
     // * UDP socket rel
     std::shared_ptr<kios::BTReceiver> udp_socket_;
 
+    // * perception rel. subscription -> tick, lock free.
+    kios::TripleBuffer<kios::PerceptionState> perception_buffer_;
+    // * the windows published since the tick last took the perception, subscription only
+    kios::TelemetryWindow unread_telemetry_;
+
+    // * tick rel
+    std::unique_ptr<kios::TickScheduler> tick_scheduler_;
+
+    // * service request in flight, guarded by tree_phase_mtx_. the tree is not ticked while it is pending.
+    bool hasPendingRequest_ = false;
+    std::uint64_t request_seq_ = 0;
+    std::uint64_t pending_request_seq_ = 0;
+    std::string pending_request_name_;
+    std::chrono::steady_clock::time_point pending_request_deadline_;
+
     // tree rel
     kios::TreePhase tree_phase_;
     std::shared_ptr<kios::TreeState> tree_state_ptr_;
@@ -176,6 +254,7 @@ private:
 
     rclcpp::TimerBase::SharedPtr timer_;
     rclcpp::Subscription<kios_interface::msg::TaskState>::SharedPtr subscription_;
+    rclcpp::Subscription<kios_interface::msg::TaskStateFixed>::SharedPtr fixed_subscription_;
     rclcpp::Client<kios_interface::srv::ArchiveActionRequest>::SharedPtr archive_action_client_;
     // rclcpp::Service<kios_interface::srv::SwitchTreePhaseRequest>::SharedPtr switch_tree_phase_server_;
     rclcpp::Client<kios_interface::srv::GetObjectRequest>::SharedPtr get_object_client_;
@@ -226,7 +305,19 @@ private:
 
         auto result = std::make_shared<ExecuteTree::Result>();
 
-        // * initialize the tree here:
+        // * swap in the new plan. a retry without a tree keeps the current one.
+        if (!goal->tree.empty())
+        {
+            if (!tree_replan(goal->tree))
+            {
+                result->result_code = 1;
+                result->node_result = "the tree is rejected";
+                goal_handle->abort(result);
+                RCLCPP_ERROR(this->get_logger(), "Goal aborted, the tree is rejected.");
+                return;
+            }
+            tick_scheduler_->notify();
+        }
 
         // ////////////////////////////////////////////////////////////////
         // rclcpp::Rate loop_rate(1);
@@ -368,21 +459,114 @@ private:
     }
 
     /**
-     * @brief update the task_state. here the lock priority is lower than timer.
+     * @brief build the tree of the first plan, replace it by the next ones. the action nodes that did not change
+     * keep their archives and their succeeded-once latches, only the archives of the new or changed nodes are
+     * sent to the tactician. an invalid plan leaves the current tree running.
+     *
+     * @param tree_string
+     * @return false if the plan is rejected
+     */
+    bool tree_replan(const std::string &tree_string)
+    {
+        std::lock_guard<std::mutex> lock_tree_phase(tree_phase_mtx_);
+        std::lock_guard<std::mutex> lock_tree(tree_mtx_);
+        auto tree_root = m_tree_root;
+        if (!tree_root)
+        {
+            tree_root = std::make_shared<Insertion::TreeRoot>(tree_state_ptr_, task_state_ptr_);
+            if (!tree_root->register_nodes())
+            {
+                return false;
+            }
+        }
+        auto update = tree_root->update_tree(tree_string);
+        if (!update.has_value())
+        {
+            RCLCPP_ERROR(this->get_logger(), "tree_replan: invalid tree, the current tree keeps running.");
+            return false;
+        }
+        m_tree_root = tree_root;
+
+        // * an archive response for the old tree is ignored. the archives it carried are sent again with the new ones.
+        if (hasPendingRequest_ && pending_request_name_ == archive_action_client_->get_service_name())
+        {
+            hasPendingRequest_ = false;
+        }
+        if (hasLoadedArchive_)
+        {
+            node_archive_list_.clear();
+        }
+        for (auto &archive : update->changed_archives)
+        {
+            node_archive_list_.push_back(archive.to_ros2_msg());
+        }
+        hasLoadedArchive_ = node_archive_list_.empty();
+        RCLCPP_INFO(this->get_logger(), "tree_replan: %zu action nodes kept, %zu to archive, %zu removed.",
+                    update->kept_count, node_archive_list_.size(), update->removed_count);
+        return true;
+    }
+
+    /**
+     * @brief publish the perception to the tick. never blocks and never waits for the tick.
      *
      * @param msg
      */
     void subscription_callback(kios_interface::msg::TaskState::SharedPtr msg)
     {
-        std::unique_lock<std::mutex> lock(tree_mtx_, std::try_to_lock);
-        if (lock.owns_lock())
+        auto &perception = perception_buffer_.write_buffer();
+        // * the write buffer holds an older state, publishing it would roll the perception back
+        if (!perception.from_ros2_msg(*msg))
         {
-            // * update task state
-            task_state_ptr_->from_ros2_msg(*msg);
+            RCLCPP_WARN(this->get_logger(), "subscription_callback: malformed task state, dropped.");
+            return;
         }
-        else
+        perception.telemetry = merge_unread_telemetry(perception.telemetry);
+        perception_buffer_.publish();
+        // * new perception, wake up the tree
+        tick_scheduler_->notify();
+    }
+
+    /**
+     * @brief fixed-size version of subscription_callback.
+     *
+     * @param msg
+     */
+    void fixed_subscription_callback(kios_interface::msg::TaskStateFixed::SharedPtr msg)
+    {
+        auto &perception = perception_buffer_.write_buffer();
+        perception.from_ros2_msg(*msg);
+        perception.telemetry = merge_unread_telemetry(perception.telemetry);
+        perception_buffer_.publish();
+        tick_scheduler_->notify();
+    }
+
+    /**
+     * @brief the tick only gets the newest perception. while it has not taken the last one, the new window
+     * is merged with the unread ones, so a peak in a skipped publish still reaches the tree.
+     *
+     * @param window the window of the new task state
+     * @return const kios::TelemetryWindow& the window to publish
+     */
+    const kios::TelemetryWindow &merge_unread_telemetry(const kios::TelemetryWindow &window)
+    {
+        unread_telemetry_ = perception_buffer_.has_unread() ? kios::merge_telemetry_windows(unread_telemetry_, window) : window;
+        return unread_telemetry_;
+    }
+
+    /**
+     * @brief take the newest perception published by the subscription into the task state read by the tree nodes.
+     * the telemetry windows of the publishes skipped in between are merged into the newest one by the subscription.
+     * the udp telemetry is decoded by the messenger (direct_telemetry), the tree gets it with the task state.
+     * ! call with tree_mtx_ held.
+     */
+    void update_perception()
+    {
+        if (perception_buffer_.update())
         {
-            RCLCPP_ERROR(this->get_logger(), "SUBSCRIPTION: LOCK FAILED. PASS.");
+            const auto &perception = perception_buffer_.read();
+            task_state_ptr_->sensor_state.test_data = perception.sensor_state.test_data;
+            task_state_ptr_->mios_state = perception.mios_state;
+            task_state_ptr_->telemetry = perception.telemetry;
         }
     }
 
@@ -419,54 +603,246 @@ private:
     // }
 
     /**
-     * @brief inline function for send the command request to commander
+     * @brief send a service request without blocking the tick. until the response arrives or the deadline
+     * expires the tree is not ticked (it stays in the current phase, PAUSE during an action switch).
+     * the handler runs in the client callback group with tree phase and tree locked, the tree is re-ticked
+     * right after it. returning false from the handler switches the tree to ERROR.
+     * ! call with tree_phase_mtx_ held.
+     *
+     * @param client
+     * @param request
+     * @param response_deadline max time in ms to wait for the response
+     * @param handler
+     * @return false if the service is not available
+     */
+    template <typename ServiceT>
+    bool send_request_async(
+        const typename rclcpp::Client<ServiceT>::SharedPtr &client,
+        const std::shared_ptr<typename ServiceT::Request> &request,
+        int response_deadline,
+        std::function<bool(std::shared_ptr<typename ServiceT::Response>)> handler)
+    {
+        if (!client->service_is_ready())
+        {
+            RCLCPP_ERROR(this->get_logger(), "Service %s is not available!", client->get_service_name());
+            return false;
+        }
+        const std::uint64_t request_seq = ++request_seq_;
+        hasPendingRequest_ = true;
+        pending_request_seq_ = request_seq;
+        pending_request_name_ = client->get_service_name();
+        pending_request_deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(response_deadline);
+
+        client->async_send_request(
+            request,
+            [this, request_seq, handler = std::move(handler)](typename rclcpp::Client<ServiceT>::SharedFuture future)
+            {
+                {
+                    std::lock_guard<std::mutex> lock_tree_phase(tree_phase_mtx_);
+                    if (!hasPendingRequest_ || pending_request_seq_ != request_seq)
+                    {
+                        // * the deadline already expired, the tree has moved on.
+                        RCLCPP_WARN(this->get_logger(), "Late response of request %lu ignored.", static_cast<unsigned long>(request_seq));
+                        return;
+                    }
+                    hasPendingRequest_ = false;
+                    std::lock_guard<std::mutex> lock_tree(tree_mtx_);
+                    if (!handler(future.get()))
+                    {
+                        switch_tree_phase("ERROR", tree_phase_);
+                    }
+                }
+                // * service replied, tick again
+                tick_scheduler_->notify();
+            });
+        return true;
+    }
+
+    /**
+     * @brief check the request in flight. on deadline expiry the request is dropped and the tree switched to ERROR.
+     * ! call with tree_phase_mtx_ held.
      *
-     * @param ready_deadline max time to wait until server is ready
+     * @return true if the tick should be skipped
+     */
+    bool is_request_pending()
+    {
+        if (!hasPendingRequest_)
+        {
+            return false;
+        }
+        if (std::chrono::steady_clock::now() < pending_request_deadline_)
+        {
+            return true;
+        }
+        RCLCPP_ERROR(this->get_logger(), "Service %s: response is not ready after the deadline!", pending_request_name_.c_str());
+        hasPendingRequest_ = false;
+        switch_tree_phase("ERROR", tree_phase_);
+        return false;
+    }
+
+    /**
+     * @brief send the command request to commander.
+     *
+     * @param cmd_type
      * @param response_deadline max time to wait until response is ready
-     * @return true
-     * @return false
+     * @param on_accepted called in the response handler if the commander accepted the command
+     * @return false if the request could not be sent
      */
-    bool send_command_request(kios::CommandType cmd_type, int ready_deadline = 50, int response_deadline = 50)
+    bool send_command_request(kios::CommandType cmd_type, int response_deadline = 1000, std::function<void()> on_accepted = nullptr)
     {
         RCLCPP_WARN_STREAM(this->get_logger(), "send_command_request: " << int(cmd_type));
         auto request = std::make_shared<kios_interface::srv::CommandRequest::Request>();
         request->command_type = static_cast<int32_t>(cmd_type);
-        request->command_context = skill_parameter_.dump();
-        request->skill_type = kios::ap_to_mios_skill(tree_state_ptr_->node_archive.action_phase);
-
-        // client send request
-        while (!command_client_->wait_for_service(std::chrono::milliseconds(ready_deadline)))
+        if (!skill_parameter_cbor_.empty())
         {
-            RCLCPP_ERROR_STREAM(this->get_logger(), "Service " << command_client_->get_service_name() << " is not available after waiting for " << ready_deadline << " miliseconds!");
-            // can try to reconnect here
-            return false;
+            request->command_context_cbor = skill_parameter_cbor_;
         }
-        auto result_future = command_client_->async_send_request(request);
-        std::future_status status = result_future.wait_until(
-            std::chrono::steady_clock::now() + std::chrono::milliseconds(response_deadline));
-        if (status == std::future_status::ready)
+        else
         {
-            auto result = result_future.get();
-            if (result->is_accepted == true)
-            {
-                RCLCPP_INFO_STREAM(this->get_logger(), "Service " << command_client_->get_service_name() << " request accepted.");
-                return true;
-            }
-            else
+            request->command_context = skill_parameter_json_;
+        }
+        request->skill_type = kios::ap_to_mios_skill(tree_state_ptr_->node_archive.action_phase);
+
+        return send_request_async<kios_interface::srv::CommandRequest>(
+            command_client_,
+            request,
+            response_deadline,
+            [this, on_accepted = std::move(on_accepted)](std::shared_ptr<kios_interface::srv::CommandRequest::Response> result)
             {
+                if (result->is_accepted == true)
+                {
+                    RCLCPP_INFO_STREAM(this->get_logger(), "Service " << command_client_->get_service_name() << " request accepted.");
+                    if (on_accepted)
+                    {
+                        on_accepted();
+                    }
+                    return true;
+                }
                 RCLCPP_ERROR_STREAM(this->get_logger(), "Service " << command_client_->get_service_name() << " request refused!");
                 return false;
+            });
+    }
+
+    /**
+     * @brief decode the forwarded skill parameter for logging.
+     */
+    std::string skill_parameter_to_string()
+    {
+        if (skill_parameter_cbor_.empty())
+        {
+            return skill_parameter_json_;
+        }
+        try
+        {
+            return nlohmann::json::from_cbor(skill_parameter_cbor_).dump();
+        }
+        catch (...)
+        {
+            return "<invalid cbor>";
+        }
+    }
+
+    /**
+     * @brief the tactician changed its context. drop the cached parameters of the other versions.
+     */
+    void context_version_callback(const std_msgs::msg::UInt64::SharedPtr msg)
+    {
+        if (context_version_.exchange(msg->data) != msg->data)
+        {
+            RCLCPP_INFO(this->get_logger(), "context version %lu, skill parameter cache invalidated.", static_cast<unsigned long>(msg->data));
+            skill_parameter_cache_.invalidate(msg->data);
+        }
+    }
+
+    /**
+     * @brief a fetch response can carry a newer version than the last one received from the topic.
+     */
+    void adopt_context_version(std::uint64_t version)
+    {
+        std::uint64_t known = context_version_.load();
+        while (version > known)
+        {
+            if (context_version_.compare_exchange_weak(known, version))
+            {
+                skill_parameter_cache_.invalidate(version);
+                return;
             }
         }
-        else
+    }
+
+    kios::CachedSkillParameter to_cached_skill_parameter(kios_interface::srv::FetchSkillParameterRequest::Response &response)
+    {
+        kios::CachedSkillParameter parameter;
+        parameter.context_version = response.context_version;
+        parameter.cbor = std::move(response.skill_parameters_cbor);
+        if (parameter.cbor.empty())
         {
-            RCLCPP_ERROR_STREAM(this->get_logger(), "UNKNOWN ERROR: Service " << command_client_->get_service_name() << " is available but response is not ready after waiting for " << response_deadline << "miliseconds!");
-            return false;
+            parameter.json = std::move(response.skill_parameters_json);
         }
+        return parameter;
     }
 
-    bool send_fetch_skill_parameter_request(int ready_deadline = 50, int response_deadline = 50)
+    /**
+     * @brief send the fetch requests of all action nodes at once. the responses fill the cache
+     * in the client callback group, the tick is not blocked.
+     */
+    void prefetch_skill_parameters()
     {
+        if (!fetch_skill_parameter_client_->service_is_ready())
+        {
+            RCLCPP_WARN(this->get_logger(), "prefetch_skill_parameters: service %s not available, skipped.", fetch_skill_parameter_client_->get_service_name());
+            return;
+        }
+        const bool accept_binary = this->get_parameter("binary_skill_parameter").as_bool();
+        auto groundings = m_tree_root->collect_groundings();
+        for (auto &grounding : groundings)
+        {
+            auto request = std::make_shared<kios_interface::srv::FetchSkillParameterRequest::Request>();
+            request->node_archive = grounding.archive.to_ros2_msg();
+            request->tree_phase = static_cast<int32_t>(tree_state_ptr_->tree_phase);
+            request->object_keys = grounding.object_keys;
+            request->object_names = grounding.object_names;
+            request->accept_binary = accept_binary;
+            fetch_skill_parameter_client_->async_send_request(
+                request,
+                [this, archive = grounding.archive, object_names = grounding.object_names](
+                    rclcpp::Client<kios_interface::srv::FetchSkillParameterRequest>::SharedFuture future)
+                {
+                    auto result = future.get();
+                    if (!result->is_accepted)
+                    {
+                        return;
+                    }
+                    adopt_context_version(result->context_version);
+                    skill_parameter_cache_.store(archive, object_names, to_cached_skill_parameter(*result));
+                });
+        }
+        RCLCPP_INFO(this->get_logger(), "prefetch_skill_parameters: %zu requests sent.", groundings.size());
+    }
+
+    /**
+     * @brief get the parameter of the current action node, then ask the commander to switch to it.
+     * a cache hit sends the command right away, otherwise the command is sent from the fetch response handler.
+     *
+     * @param response_deadline max time to wait for each response
+     * @return false if a request could not be sent
+     */
+    bool send_fetch_skill_parameter_request(int response_deadline = 1000)
+    {
+        const kios::NodeArchive &archive = tree_state_ptr_->node_archive;
+        const std::vector<std::string> &object_names = tree_state_ptr_->object_names;
+        const bool useCache = this->get_parameter("skill_parameter_cache").as_bool();
+
+        // * the same action with the same objects again (retry, loop): no round-trip
+        kios::CachedSkillParameter cached_parameter;
+        if (useCache && skill_parameter_cache_.lookup(archive, object_names, context_version_.load(), cached_parameter))
+        {
+            RCLCPP_INFO(this->get_logger(), "skill parameter of group %d id %d taken from cache.", archive.action_group, archive.action_id);
+            skill_parameter_cbor_ = std::move(cached_parameter.cbor);
+            skill_parameter_json_ = std::move(cached_parameter.json);
+            return send_start_new_request(response_deadline);
+        }
+
         // * send request to update the object
         auto request = std::make_shared<kios_interface::srv::FetchSkillParameterRequest::Request>();
 
@@ -480,46 +856,46 @@ private:
         request->object_keys = tree_state_ptr_->object_keys;
         request->object_names = tree_state_ptr_->object_names;
 
-        int try_times = 5;
-        while (!fetch_skill_parameter_client_->wait_for_service(std::chrono::milliseconds(ready_deadline)))
-        {
-            try_times--;
-            if (try_times == 0)
-            {
-                RCLCPP_ERROR(this->get_logger(), "service %s not available after retries.", fetch_skill_parameter_client_->get_service_name());
-                return false;
-            }
-            continue;
-        }
-        auto result_future = fetch_skill_parameter_client_->async_send_request(request);
-        std::future_status status = result_future.wait_until(
-            std::chrono::steady_clock::now() + std::chrono::milliseconds(response_deadline));
-        if (status == std::future_status::ready)
-        {
-            auto result = result_future.get();
-            if (result->is_accepted == true)
+        // * ask for cbor, the tactician falls back to json text if it does not support it
+        request->accept_binary = this->get_parameter("binary_skill_parameter").as_bool();
+
+        return send_request_async<kios_interface::srv::FetchSkillParameterRequest>(
+            fetch_skill_parameter_client_,
+            request,
+            response_deadline,
+            [this, archive, object_names, useCache, response_deadline](std::shared_ptr<kios_interface::srv::FetchSkillParameterRequest::Response> result)
             {
+                if (result->is_accepted == false)
+                {
+                    RCLCPP_ERROR(this->get_logger(), "Service %s response: request refused!", fetch_skill_parameter_client_->get_service_name());
+                    return false;
+                }
                 RCLCPP_INFO(this->get_logger(), "Service %s response: request accepted.", fetch_skill_parameter_client_->get_service_name());
-                // ! hier ist try/catch noetig
-                skill_parameter_ = nlohmann::json::parse(result->skill_parameters_json);
-                return true;
-            }
-            else
-            {
-                RCLCPP_ERROR(this->get_logger(), "Service %s response: request refused!", fetch_skill_parameter_client_->get_service_name());
-                return false;
-            }
-        }
-        else
-        {
-            RCLCPP_ERROR(this->get_logger(), "UNKNOWN ERROR: service %s future is available but not ready.", fetch_skill_parameter_client_->get_service_name());
-            return false;
-        }
+                kios::CachedSkillParameter parameter = to_cached_skill_parameter(*result);
+                if (useCache)
+                {
+                    adopt_context_version(parameter.context_version);
+                    skill_parameter_cache_.store(archive, object_names, parameter);
+                }
+                skill_parameter_cbor_ = std::move(parameter.cbor);
+                skill_parameter_json_ = std::move(parameter.json);
+                return send_start_new_request(response_deadline);
+            });
+    }
+
+    /**
+     * @brief the skill parameter is ready, stop the old task and start the new one at mios side.
+     */
+    bool send_start_new_request(int response_deadline)
+    {
+        RCLCPP_DEBUG_STREAM(this->get_logger(), "skill parameter: " << skill_parameter_to_string());
+        return send_command_request(kios::CommandType::STOP_OLD_START_NEW, response_deadline);
     }
 
     /**
      * @brief THE MAINLINE OF THE NODE.
-     * * timer is used for testing the executing part of kios.
+     * * called by the tick scheduler on every event (udp phase message, task state, service reply)
+     * * or at the latest after max_tick_period_ms.
      */
     void timer_callback()
     {
@@ -528,22 +904,30 @@ private:
             RCLCPP_INFO_ONCE(this->get_logger(), "Timer works...");
             // * lock tree phase first
             std::lock_guard<std::mutex> lock_tree_phase(tree_phase_mtx_);
+            // * the tree is set by tree_replan under the same lock
+            if (!m_tree_root)
+            {
+                RCLCPP_WARN_ONCE(this->get_logger(), "Tree is not initialized yet, tick pass...");
+                return;
+            }
+            // * a service request is in flight, its response handler re-ticks the tree.
+            if (is_request_pending())
+            {
+                return;
+            }
             // * check the necessity of updating objects
-            if (hasUpdatedObjects_ == false)
+            if (hasUpdatedObjects_ == false && tree_phase_ != kios::TreePhase::ERROR)
             {
                 RCLCPP_INFO(this->get_logger(), "update the object...");
-                if (update_object(1000, 1000) == false)
-                {
-                    switch_tree_phase("ERROR", tree_phase_);
-                }
-                else
+                if (update_object(1000))
                 {
-                    hasUpdatedObjects_ = true;
+                    return;
                 }
+                switch_tree_phase("ERROR", tree_phase_);
             }
 
             // * ask tactician to load the actions' parameters according to the archives.
-            if (hasLoadedArchive_ == false)
+            if (hasLoadedArchive_ == false && tree_phase_ != kios::TreePhase::ERROR)
             {
                 // !! BB: THE CORRECT ORDER SHOULD BE FETCH THE OBJECT, GENERATE THE TREE, THEN CHECK THE OBJECTS WHEN GENERATING THE TREE.
                 // ! NOW JUST CHECK THE OBJECT HERE.
@@ -552,15 +936,14 @@ private:
                     switch_tree_phase("ERROR", tree_phase_);
                 }
                 // !!
-
-                RCLCPP_INFO_STREAM(this->get_logger(), "Now ask the tactician to Load the archives...");
-                if (load_node_archive(1000, 1000) == false)
-                {
-                    switch_tree_phase("ERROR", tree_phase_);
-                }
                 else
                 {
-                    hasLoadedArchive_ = true;
+                    RCLCPP_INFO_STREAM(this->get_logger(), "Now ask the tactician to Load the archives...");
+                    if (load_node_archive(1000))
+                    {
+                        return;
+                    }
+                    switch_tree_phase("ERROR", tree_phase_);
                 }
             }
 
@@ -578,6 +961,7 @@ private:
 
             // * lock tree first
             std::lock_guard<std::mutex> lock_tree(tree_mtx_);
+            update_perception();
             // * update tree phase in tree state for the need in BT
             tree_state_ptr_->tree_phase = tree_phase_;
             // * do tree cycle
@@ -683,18 +1067,15 @@ private:
             RCLCPP_INFO(this->get_logger(), "tree_cycle: FINISH.");
             tree_state_ptr_->action_name = "finish";
             tree_state_ptr_->action_phase = kios::ActionPhase::FINISH;
-            skill_parameter_ = {};
+            skill_parameter_cbor_.clear();
+            skill_parameter_json_ = "null";
             // * all tasks in tree finished. first send request to finish all actions at mios side.
-            // * stop the tasks on mios side.
-            if (!send_command_request(kios::CommandType::STOP_OLD_TASK, 1000, 1000))
+            // * stop the tasks on mios side. turn off once the commander accepted.
+            if (!send_command_request(kios::CommandType::STOP_OLD_TASK, 1000, [this]() { switch_power(false); }))
             {
                 RCLCPP_ERROR(this->get_logger(), "tree_cycle at FINISH: failed when sending stop request.");
                 switch_tree_phase("ERROR", tree_phase_);
             }
-            else
-            {
-                switch_power(false);
-            }
             break;
         }
 
@@ -736,15 +1117,10 @@ private:
                 // * update the tree_phase in BT. (TRY REMOVE THIS.)
                 tree_state_ptr_->tree_phase = tree_phase_;
 
-                // * get the parameter of the acion node (skill)
+                // * get the parameter of the acion node (skill) and switch the mios task.
+                // * the tree stays in PAUSE until the responses arrive.
                 RCLCPP_INFO_STREAM(this->get_logger(), "fetch skill parameter.");
-                if (!send_fetch_skill_parameter_request(1000, 1000))
-                {
-                    switch_tree_phase("ERROR", tree_phase_);
-                    return;
-                }
-                std::cout << "skill parameter: " << skill_parameter_.dump() << std::endl;
-                if (!send_command_request(kios::CommandType::STOP_OLD_START_NEW, 1000, 1000))
+                if (!send_fetch_skill_parameter_request(1000))
                 {
                     switch_tree_phase("ERROR", tree_phase_);
                 }
@@ -801,121 +1177,84 @@ private:
     }
 
     /**
-     * @brief update the object with GetObjectRequest client
-     * @return true
-     * @return false
+     * @brief update the object with GetObjectRequest client. the object dictionary is swapped in the response handler.
+     * @return false if the request could not be sent
      */
-    bool update_object(int ready_deadline = 100, int response_deadline = 1000)
+    bool update_object(int response_deadline = 1000)
     {
         // * send request to update the object
         auto request = std::make_shared<kios_interface::srv::GetObjectRequest::Request>();
-        while (!get_object_client_->wait_for_service(std::chrono::milliseconds(ready_deadline)))
-        {
-            if (!rclcpp::ok())
-            {
-                RCLCPP_ERROR(this->get_logger(), "Interrupted while waiting for the service. Exiting.");
-                switch_power(false);
-                return false;
-            }
-            RCLCPP_ERROR(this->get_logger(), "service get_object_service is timeout for getting ready!");
-            switch_power(false);
-            return false;
-        }
-        auto result_future = get_object_client_->async_send_request(request);
-        std::future_status status = result_future.wait_until(
-            std::chrono::steady_clock::now() + std::chrono::milliseconds(response_deadline));
-        if (status == std::future_status::ready)
-        {
-            auto result = result_future.get();
-            if (result->is_accepted == true)
+        return send_request_async<kios_interface::srv::GetObjectRequest>(
+            get_object_client_,
+            request,
+            response_deadline,
+            [this](std::shared_ptr<kios_interface::srv::GetObjectRequest::Response> result)
             {
+                if (result->is_accepted == false)
+                {
+                    RCLCPP_ERROR_STREAM(this->get_logger(), "get_object_service: Service call failed! Error message:" << result->error_message);
+                    return false;
+                }
                 RCLCPP_INFO(this->get_logger(), "get_object_service: Service call succeeded.");
                 std::unordered_map<std::string, kios::Object> object_dict_;
                 try
                 {
-                    // std::cout << "READ START" << std::endl;
                     for (int i = 0; i < result->object_name.size(); i++)
                     {
                         auto p = std::make_pair(result->object_name[i], kios::Object::from_json(nlohmann::json::parse(result->object_data[i])));
                         object_dict_.emplace(p);
                     }
-                    // std::cout << "SWAP" << std::endl;
                     // * update the object dictionary in task state
                     task_state_ptr_->object_dictionary.swap(object_dict_);
-                    // std::cout << "READ FINISH" << std::endl;
-                    return true;
                 }
                 catch (...)
                 {
                     RCLCPP_FATAL(this->get_logger(), "get_object_service: ERROR IN JSON FILE PARSING!");
                     return false;
                 }
-            }
-            else
-            {
-                RCLCPP_ERROR_STREAM(this->get_logger(), "get_object_service: Service call failed! Error message:" << result->error_message);
-                return false;
-            }
-        }
-        else
-        {
-            RCLCPP_ERROR(this->get_logger(), "get_object_service: Service call timed out!");
-            return false;
-        }
+                hasUpdatedObjects_ = true;
+                return true;
+            });
     }
 
     /**
      * @brief send a request to tactician for archiving the nodes in the current BT.
      *
-     * @param ready_deadline
      * @param response_deadline
-     * @return true
-     * @return false
+     * @return false if the request could not be sent
      */
-    bool load_node_archive(int ready_deadline = 100, int response_deadline = 1000)
+    bool load_node_archive(int response_deadline = 1000)
     {
-        auto service_name = archive_action_client_->get_service_name();
         // * send request to update the object
         auto request = std::make_shared<kios_interface::srv::ArchiveActionRequest::Request>();
         // update the archive node list
         request->archive_list = node_archive_list_;
-        while (!archive_action_client_->wait_for_service(std::chrono::milliseconds(ready_deadline)))
-        {
-            if (!rclcpp::ok())
-            {
-                RCLCPP_ERROR(this->get_logger(), "Interrupted while waiting for the service. Exiting.");
-                switch_power(false);
-                return false;
-            }
-            RCLCPP_ERROR_STREAM(this->get_logger(), "service " << service_name << "is timeout for getting ready!");
-            switch_power(false);
-            return false;
-        }
-        auto result_future = archive_action_client_->async_send_request(request);
-        std::future_status status = result_future.wait_until(
-            std::chrono::steady_clock::now() + std::chrono::milliseconds(response_deadline));
-        if (status == std::future_status::ready)
-        {
-            auto result = result_future.get();
-            if (result->is_accepted == true)
+        return send_request_async<kios_interface::srv::ArchiveActionRequest>(
+            archive_action_client_,
+            request,
+            response_deadline,
+            [this](std::shared_ptr<kios_interface::srv::ArchiveActionRequest::Response> result)
             {
+                auto service_name = archive_action_client_->get_service_name();
+                if (result->is_accepted == false)
+                {
+                    RCLCPP_ERROR_STREAM(this->get_logger(), "Service " << service_name << ": Service call failed! Error message: " << result->error_message);
+                    return false;
+                }
                 RCLCPP_INFO_STREAM(this->get_logger(), "Service " << service_name << ": Service call succeeded.");
+                hasLoadedArchive_ = true;
+                if (this->get_parameter("prefetch_skill_parameters").as_bool())
+                {
+                    prefetch_skill_parameters();
+                }
                 return true;
-            }
-            else
-            {
-                RCLCPP_ERROR_STREAM(this->get_logger(), "Service " << service_name << ": Service call failed! Error message: " << result->error_message);
-                return false;
-            }
-        }
-        else
-        {
-            RCLCPP_ERROR(this->get_logger(), "get_object_service: Service call timed out!");
-            return false;
-        }
+            });
     }
 };
 
+#ifdef KIOS_COMPONENT
+RCLCPP_COMPONENTS_REGISTER_NODE(TreeNode)
+#else
 int main(int argc, char *argv[])
 {
     rclcpp::init(argc, argv);
@@ -929,4 +1268,5 @@ int main(int argc, char *argv[])
     // * unregister the udp before shutdown.
     rclcpp::shutdown();
     return 0;
-}
\ No newline at end of file
+}
+#endif
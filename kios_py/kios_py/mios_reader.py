@@ -20,6 +20,7 @@ from .resource.udp_receiver import UDPReceiver
 from .resource.ws_client import *
 
 from kios_interface.msg import MiosState
+from kios_interface.msg import MiosStateFixed
 
 
 class MiosReader(Node):
@@ -55,6 +56,11 @@ class MiosReader(Node):
 
         # declare parameters
         self.declare_parameter("power", True)
+        # publish the fixed-size message version for the messenger
+        self.declare_parameter("fixed_size_state", False)
+        self.isFixedSizeState = (
+            self.get_parameter("fixed_size_state").get_parameter_value().bool_value
+        )
 
         # * new udp receiver!
         self.udp_receiver_ = UDPReceiver()
@@ -68,9 +74,17 @@ class MiosReader(Node):
             0.1, self.timer_callback, callback_group=timer_callback_group  # sec
         )
 
-        self.publisher = self.create_publisher(
-            MiosState, "mios_state_topic", 10, callback_group=publisher_callback_group
-        )
+        if self.isFixedSizeState:
+            self.publisher = self.create_publisher(
+                MiosStateFixed,
+                "mios_state_fixed_topic",
+                10,
+                callback_group=publisher_callback_group,
+            )
+        else:
+            self.publisher = self.create_publisher(
+                MiosState, "mios_state_topic", 10, callback_group=publisher_callback_group
+            )
 
         time.sleep(2)
 
@@ -85,7 +99,7 @@ class MiosReader(Node):
             else:
                 pass
 
-            pub_msg = MiosState()
+            pub_msg = MiosStateFixed() if self.isFixedSizeState else MiosState()
             udp_msg = self.udp_receiver_.get_last_message()
             if udp_msg:
                 # * msg received, publish new.